@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -13,6 +13,31 @@ TEMPLATE = app
 
 
 SOURCES += main.cpp\
-        plot.cpp
+        plot.cpp \
+    datasource.cpp \
+    graphrenderer.cpp \
+    plotcli.cpp \
+    polycalc.cpp \
+    polyjit.cpp \
+    polyoptimizer.cpp \
+    sampler.cpp \
+    seriesbuffer.cpp \
+    seriesrenderer.cpp \
+    vecmath.cpp
 
-HEADERS  += plot.h
+HEADERS  += plot.h \
+    datasource.h \
+    dual.h \
+    graphrenderer.h \
+    plotcli.h \
+    polycalc.h \
+    polyjit.h \
+    polyoptimizer.h \
+    sampler.h \
+    seriesbuffer.h \
+    seriesrenderer.h \
+    vecmath.h
+
+# AVX2 를 지원하는 CPU 에서만 실행한다면, 아래 줄의 주석을 풀어 AVX2 로
+# 다항식을 계산할 수 있다. 기본은 SSE2 이다.
+#QMAKE_CXXFLAGS += -mavx2
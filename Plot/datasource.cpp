@@ -0,0 +1,592 @@
+/****************************************************************************
+**
+** datasource.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "datasource.h"
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief DataSource 생성자
+ * @param parent 부모 객체
+ */
+DataSource::DataSource(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief DataSource 소멸자
+ */
+DataSource::~DataSource()
+{
+}
+
+/**
+ * @brief 쌓인 점을 모두 가져간다
+ * @param xs x 값들을 돌려받음
+ * @param ys y 값들을 돌려받음
+ * @return 가져간 점 수
+ */
+int DataSource::take(QVector<double> *xs, QVector<float> *ys)
+{
+    QMutexLocker locker(&_mutex);
+
+    // 복사하지 않고 맞바꿈
+    xs->clear();
+    ys->clear();
+
+    xs->swap(_pendingXs);
+    ys->swap(_pendingYs);
+
+    return xs->size();
+}
+
+/**
+ * @brief 읽은 점들을 대기열에 더한다
+ * @param xs x 값들
+ * @param ys y 값들
+ * @remark 대기열이 비어 있었을 때만 dataAvailable() 을 발생한다
+ */
+void DataSource::push(const QVector<double> &xs, const QVector<float> &ys)
+{
+    if (xs.isEmpty())
+        return;
+
+    bool wasEmpty;
+
+    {
+        QMutexLocker locker(&_mutex);
+
+        wasEmpty = _pendingXs.isEmpty();
+
+        _pendingXs += xs;
+        _pendingYs += ys;
+    }
+
+    if (wasEmpty)
+        emit dataAvailable();
+}
+
+/**
+ * @brief 값 하나를 숫자로 해석한다
+ * @param begin 값의 시작
+ * @param end 값의 끝
+ * @param value 해석한 숫자를 돌려받음
+ * @return 값 전체가 숫자이면 true, 아니면 false
+ * @remark 스택의 버퍼에 복사해 strtod() 로 읽으므로 할당하지 않는다.
+ *         strtod() 는 로캘의 소수점을 따르므로 '.' 을 그것으로 바꾼다
+ */
+static bool parseNumber(const char *begin, const char *end, double *value)
+{
+    char buffer[64];
+    int length = static_cast<int>(end - begin);
+
+    // 숫자로 보기에 너무 긴 값
+    if (length >= static_cast<int>(sizeof(buffer)))
+        return false;
+
+    memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+
+    const char point = *localeconv()->decimal_point;
+
+    if (point != '.')
+    {
+        if (char *dot = static_cast<char *>(memchr(buffer, '.', length)))
+            *dot = point;
+    }
+
+    char *parsed;
+
+    *value = strtod(buffer, &parsed);
+
+    return parsed == buffer + length;
+}
+
+/**
+ * @brief CSV 줄들을 해석한다
+ * @param data 읽은 바이트들
+ * @param size 바이트 수
+ * @param index 다음 점의 번호. 'y' 만 있는 줄의 x 값으로 쓰이고, 점마다
+ *              늘어남
+ * @param xs 해석한 x 값들이 더해짐
+ * @param ys 해석한 y 값들이 더해짐
+ * @return 해석한 바이트 수. 줄바꿈으로 끝나지 않은 마지막 줄은 남김
+ * @remark 값은 쉼표, 쌍반점, 탭, 공백으로 나눈다. 앞의 두 값 중 숫자가
+ *         아닌 것이 있는 줄은 머리줄이나 잘못된 줄로 보고 건너뛴다. 값이
+ *         하나뿐인 줄만 'y' 로 읽는다. 숫자는 로캘과 관계없이 '.' 을
+ *         소수점으로 쓴다.
+ */
+int DataSource::parseCsv(const char *data, int size, qint64 *index,
+                         QVector<double> *xs, QVector<float> *ys)
+{
+    const char *end = data + size;
+    const char *line = data;
+
+    for (;;)
+    {
+        const char *eol = static_cast<const char *>(
+                              memchr(line, '\n', end - line));
+
+        if (!eol)
+            break;
+
+        // 줄을 값들로 나누어 앞의 두 개까지 해석
+        double values[2];
+        int count = 0;
+        bool ok = true;
+        const char *p = line;
+
+        while (ok && count < 2)
+        {
+            while (p < eol && strchr(",; \t\r", *p))
+                ++p;
+
+            const char *token = p;
+
+            while (p < eol && !strchr(",; \t\r", *p))
+                ++p;
+
+            if (token == p)
+                break;
+
+            ok = parseNumber(token, p, &values[count]);
+
+            if (ok)
+                count++;
+        }
+
+        if (ok && count == 1)
+            values[1] = values[0], values[0] = static_cast<double>(*index);
+
+        if (ok && count > 0)
+        {
+            xs->append(values[0]);
+            ys->append(static_cast<float>(values[1]));
+
+            ++*index;
+        }
+
+        line = eol + 1;
+    }
+
+    return line - data;
+}
+
+/**
+ * @brief CSV 파일 원본
+ *
+ * 주기적으로 파일 끝을 살펴 늘어난 만큼 이어서 읽는다.
+ */
+class CsvFileSource : public DataSource
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief CsvFileSource 생성자
+     * @param fileName 파일 이름
+     * @param parent 부모 객체
+     */
+    CsvFileSource(const QString &fileName, QObject *parent)
+        : DataSource(parent)
+        , _file(fileName)
+        , _index(0)
+    {
+        connect(&_timer, SIGNAL(timeout()), this, SLOT(poll()));
+    }
+
+    /**
+     * @brief 읽기를 시작한다
+     * @param error 실패하면 오류 내용을 돌려받음
+     * @return 시작했으면 true, 아니면 false
+     */
+    bool start(QString *error)
+    {
+        if (!_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+        {
+            *error = _file.errorString();
+
+            return false;
+        }
+
+        poll();
+
+        _timer.start(PollInterval);
+
+        return true;
+    }
+
+private:
+    enum
+    {
+        PollInterval = 50,          ///< ms 단위의 파일 살피기 간격
+        ChunkSize = 1 << 16,        ///< 한 번에 읽을 바이트 수
+        MaxBytesPerPoll = 8 << 20   ///< 한 번 살필 때 읽을 최대 바이트 수
+    };
+
+    QFile _file;        ///< 읽는 파일
+    QTimer _timer;      ///< 파일 살피기 타이머
+    QByteArray _rest;   ///< 줄바꿈으로 끝나지 않은 마지막 줄
+    qint64 _index;      ///< 다음 점의 번호
+
+private slots:
+    /**
+     * @brief 늘어난 부분을 읽는다
+     * @remark 큰 파일은 여러 번에 나누어 읽어 GUI 가 멈추지 않게 한다
+     */
+    void poll()
+    {
+        QVector<double> xs;
+        QVector<float> ys;
+
+        for (int bytes = 0; bytes < MaxBytesPerPoll; )
+        {
+            QByteArray chunk = _file.read(ChunkSize);
+
+            if (chunk.isEmpty())
+                break;
+
+            bytes += chunk.size();
+            _rest += chunk;
+
+            _rest.remove(0, parseCsv(_rest.constData(), _rest.size(),
+                                     &_index, &xs, &ys));
+        }
+
+        push(xs, ys);
+    }
+};
+
+/**
+ * @brief float 배열 파일 원본
+ *
+ * 파일을 메모리에 사상해 native 바이트 순서의 float 들을 y 값으로, 위치를
+ * x 값으로 읽는다. 파일이 늘어나면 다시 사상해 이어서 읽는다.
+ */
+class MappedFloatSource : public DataSource
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief MappedFloatSource 생성자
+     * @param fileName 파일 이름
+     * @param parent 부모 객체
+     */
+    MappedFloatSource(const QString &fileName, QObject *parent)
+        : DataSource(parent)
+        , _file(fileName)
+        , _map(0)
+        , _mappedSize(0)
+        , _index(0)
+    {
+        connect(&_timer, SIGNAL(timeout()), this, SLOT(poll()));
+    }
+
+    /**
+     * @brief 읽기를 시작한다
+     * @param error 실패하면 오류 내용을 돌려받음
+     * @return 시작했으면 true, 아니면 false
+     */
+    bool start(QString *error)
+    {
+        if (!_file.open(QIODevice::ReadOnly))
+        {
+            *error = _file.errorString();
+
+            return false;
+        }
+
+        poll();
+
+        _timer.start(PollInterval);
+
+        return true;
+    }
+
+private:
+    enum
+    {
+        PollInterval = 50,              ///< ms 단위의 파일 살피기 간격
+        MaxPointsPerPoll = 1 << 22      ///< 한 번 살필 때 읽을 최대 점 수
+    };
+
+    QFile _file;        ///< 읽는 파일
+    QTimer _timer;      ///< 파일 살피기 타이머
+    uchar *_map;        ///< 사상된 메모리
+    qint64 _mappedSize; ///< 사상된 바이트 수
+    qint64 _index;      ///< 다음에 읽을 float 의 번호
+
+private slots:
+    /**
+     * @brief 늘어난 부분을 읽는다
+     */
+    void poll()
+    {
+        qint64 count = _file.size() / sizeof(float);
+
+        if (count <= _index)
+            return;
+
+        // 늘어난 부분까지 다시 사상
+        if (count * static_cast<qint64>(sizeof(float)) > _mappedSize)
+        {
+            if (_map)
+                _file.unmap(_map);
+
+            _mappedSize = count * sizeof(float);
+            _map = _file.map(0, _mappedSize);
+
+            if (!_map)
+            {
+                _timer.stop();
+
+                emit finished();
+
+                return;
+            }
+        }
+
+        const float *values = reinterpret_cast<const float *>(_map);
+        int n = static_cast<int>(qMin<qint64>(count - _index,
+                                              MaxPointsPerPoll));
+
+        QVector<double> xs(n);
+        QVector<float> ys(n);
+
+        for (int i = 0; i < n; ++i)
+        {
+            xs[i] = static_cast<double>(_index + i);
+            ys[i] = values[_index + i];
+        }
+
+        _index += n;
+
+        push(xs, ys);
+    }
+};
+
+/**
+ * @brief 표준 입력 원본
+ *
+ * 읽기는 멈출 수 있으므로 따로 스레드에서 읽는다. 읽을 수 있는 만큼씩
+ * 받아 해석하므로, 느린 파이프에서도 들어오는 대로 그려진다. 입력을
+ * 기다릴 때는 PollInterval 마다 깨어나 멈추라는 요청을 살핀다.
+ */
+class StdinSource : public DataSource
+{
+public:
+    /**
+     * @brief StdinSource 생성자
+     * @param parent 부모 객체
+     */
+    explicit StdinSource(QObject *parent)
+        : DataSource(parent)
+        , _reader(this)
+    {
+        connect(&_reader, SIGNAL(finished()), this, SIGNAL(finished()));
+    }
+
+    /**
+     * @brief StdinSource 소멸자
+     * @remark 읽는 스레드에 멈추라고 알리고, 끝날 때까지 기다린다
+     */
+    ~StdinSource()
+    {
+        _stop.storeRelease(1);
+        _reader.wait();
+    }
+
+    /**
+     * @brief 읽기를 시작한다
+     * @return 항상 true
+     */
+    bool start(QString */*error*/)
+    {
+        _reader.start();
+
+        return true;
+    }
+
+private:
+    /**
+     * @brief 표준 입력을 읽는 스레드
+     */
+    class Reader : public QThread
+    {
+    public:
+        /**
+         * @brief Reader 생성자
+         * @param source 읽은 점을 넘길 원본
+         */
+        explicit Reader(StdinSource *source)
+            : _source(source)
+        {
+        }
+
+    protected:
+        /**
+         * @brief 표준 입력이 끝날 때까지 읽는다
+         */
+        void run()
+        {
+            _source->readAll();
+        }
+
+    private:
+        StdinSource *_source;   ///< 읽은 점을 넘길 원본
+    };
+
+    enum
+    {
+        ChunkSize = 1 << 16,    ///< 한 번에 읽을 최대 바이트 수
+        PollInterval = 100      ///< ms 단위의 멈춤 요청 살피기 간격
+    };
+
+    Reader _reader;     ///< 읽는 스레드
+    QAtomicInt _stop;   ///< 0 이 아니면 읽기를 멈춤
+
+    /**
+     * @brief 표준 입력을 읽을 수 있을 때까지 기다린다
+     * @return 읽을 수 있거나 입력이 끝났으면 true, 멈추라는 요청을 받았으면
+     *         false
+     * @remark 오류도 true 를 돌려 readInput() 이 알리게 한다. Windows 에서
+     *         파이프가 아닌 입력은 기다리지 않는다
+     */
+    bool waitForInput() const
+    {
+        while (!_stop.loadAcquire())
+        {
+#ifdef Q_OS_WIN
+            DWORD available = 0;
+
+            if (!PeekNamedPipe(GetStdHandle(STD_INPUT_HANDLE), 0, 0, 0,
+                               &available, 0) || available > 0)
+                return true;
+
+            QThread::msleep(PollInterval);
+#else
+            pollfd input = {0, POLLIN, 0};
+            int ready = ::poll(&input, 1, PollInterval);
+
+            if (ready > 0 || (ready < 0 && errno != EINTR))
+                return true;
+#endif
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief 읽을 수 있는 만큼 표준 입력을 읽는다
+     * @param buffer 읽은 바이트를 받을 버퍼
+     * @param size 버퍼 크기
+     * @return 읽은 바이트 수. 끝이면 0, 오류이면 음수
+     * @remark QFile 은 요청한 크기를 다 채울 때까지 기다리므로 직접 읽는다
+     */
+    static int readInput(char *buffer, int size)
+    {
+#ifdef Q_OS_WIN
+        return _read(0, buffer, size);
+#else
+        return ::read(0, buffer, size);
+#endif
+    }
+
+    /**
+     * @brief 표준 입력이 끝날 때까지 읽어 점을 넘긴다
+     */
+    void readAll()
+    {
+        QByteArray rest;
+        qint64 index = 0;
+        char buffer[ChunkSize];
+        int len;
+
+        while (waitForInput()
+               && (len = readInput(buffer, sizeof(buffer))) > 0)
+        {
+            QVector<double> xs;
+            QVector<float> ys;
+
+            rest.append(buffer, len);
+            rest.remove(0, parseCsv(rest.constData(), rest.size(),
+                                    &index, &xs, &ys));
+
+            push(xs, ys);
+        }
+
+        if (_stop.loadAcquire())
+            return;
+
+        // 마지막 줄은 줄바꿈 없이 끝날 수 있음
+        QVector<double> xs;
+        QVector<float> ys;
+
+        rest.append('\n');
+        parseCsv(rest.constData(), rest.size(), &index, &xs, &ys);
+
+        push(xs, ys);
+    }
+};
+
+/**
+ * @brief 이름에 맞는 데이터 원본을 만든다
+ * @param name 파일 이름. '-' 이면 표준 입력
+ * @param parent 부모 객체
+ * @return 만든 데이터 원본. 아직 읽기를 시작하지 않은 상태
+ * @remark 확장자가 f32 나 bin 이면 float 배열, 나머지는 CSV 로 읽는다
+ */
+DataSource *DataSource::create(const QString &name, QObject *parent)
+{
+    if (name == "-")
+        return new StdinSource(parent);
+
+    QString suffix = QFileInfo(name).suffix().toLower();
+
+    if (suffix == "f32" || suffix == "bin")
+        return new MappedFloatSource(name, parent);
+
+    return new CsvFileSource(name, parent);
+}
+
+#include "datasource.moc"
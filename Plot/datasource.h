@@ -0,0 +1,89 @@
+/****************************************************************************
+**
+** datasource.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef DATASOURCE_H
+#define DATASOURCE_H
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 실시간 데이터 원본
+ *
+ * 파일이나 파이프에서 점을 읽어 대기열에 쌓고, 대기열이 비어 있다가
+ * 점이 들어오면 dataAvailable() 을 발생한다. 받는 쪽은 take() 로 쌓인 점을
+ * 한꺼번에 가져간다. 점이 아무리 빨리 들어와도 가져가기 전까지는 신호를
+ * 한 번만 보내므로, 화면은 한 번에 여러 점을 그린다.
+ *
+ * 읽는 스레드와 가져가는 스레드가 달라도 된다.
+ *
+ * 다음 원본을 쓸 수 있다.
+ * - CSV 파일. 한 줄에 'x,y' 또는 'y'. 파일이 늘어나면 이어서 읽음
+ * - float 배열 파일(.f32, .bin). 메모리에 사상해 y 값으로 읽음
+ * - 표준 입력('-'). CSV 와 같은 형식
+ */
+class DataSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DataSource(QObject *parent = 0);
+    virtual ~DataSource();
+
+    /**
+     * @brief 읽기를 시작한다
+     * @param error 실패하면 오류 내용을 돌려받음
+     * @return 시작했으면 true, 아니면 false
+     */
+    virtual bool start(QString *error) = 0;
+
+    int take(QVector<double> *xs, QVector<float> *ys);
+
+    static DataSource *create(const QString &name, QObject *parent = 0);
+
+    static int parseCsv(const char *data, int size, qint64 *index,
+                        QVector<double> *xs, QVector<float> *ys);
+
+signals:
+    /**
+     * @brief 빈 대기열에 점이 들어왔을 때 발생한다
+     */
+    void dataAvailable();
+
+    /**
+     * @brief 더 읽을 것이 없을 때 발생한다
+     */
+    void finished();
+
+protected:
+    void push(const QVector<double> &xs, const QVector<float> &ys);
+
+private:
+    QMutex _mutex;                  ///< 대기열 보호
+    QVector<double> _pendingXs;     ///< 가져가지 않은 점의 x 값
+    QVector<float> _pendingYs;      ///< 가져가지 않은 점의 y 값
+};
+
+#endif // DATASOURCE_H
@@ -0,0 +1,185 @@
+/****************************************************************************
+**
+** dual.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <cmath>
+
+/**
+ * @brief 이원수
+ *
+ * 값과 미분값을 함께 가지는 수로, 전진 모드 자동 미분에 쓴다. x 를
+ * Dual(x, 1) 로 두고 식을 계산하면, 결과의 derivative() 가 그 점에서의
+ * 미분값이다. 계산 순서는 값만 계산할 때와 같으므로, 스택 기계를 그대로
+ * 쓸 수 있다.
+ *
+ * T 로 Dual 을 다시 쓰면 2 계 미분도 구할 수 있다.
+ */
+template <typename T>
+class Dual
+{
+public:
+    /**
+     * @brief Dual 생성자
+     * @param value 값
+     * @param derivative 미분값. 상수이면 0
+     */
+    Dual(T value = T(0), T derivative = T(0))
+        : _value(value)
+        , _derivative(derivative)
+    {
+    }
+
+    /**
+     * @brief 값을 돌려준다
+     * @return 값
+     */
+    T value() const
+    {
+        return _value;
+    }
+
+    /**
+     * @brief 미분값을 돌려준다
+     * @return 미분값
+     */
+    T derivative() const
+    {
+        return _derivative;
+    }
+
+    Dual &operator+=(const Dual &b)
+    {
+        _value += b._value;
+        _derivative += b._derivative;
+
+        return *this;
+    }
+
+    Dual &operator-=(const Dual &b)
+    {
+        _value -= b._value;
+        _derivative -= b._derivative;
+
+        return *this;
+    }
+
+    Dual &operator*=(const Dual &b)
+    {
+        // (uv)' = u'v + uv'
+        _derivative = _derivative * b._value + _value * b._derivative;
+        _value *= b._value;
+
+        return *this;
+    }
+
+    Dual &operator/=(const Dual &b)
+    {
+        // (u/v)' = (u'v - uv') / v^2
+        _derivative = (_derivative * b._value - _value * b._derivative)
+                      / (b._value * b._value);
+        _value /= b._value;
+
+        return *this;
+    }
+
+    friend Dual operator-(const Dual &a)
+    {
+        return Dual(-a._value, -a._derivative);
+    }
+
+    friend Dual operator+(Dual a, const Dual &b)
+    {
+        return a += b;
+    }
+
+    friend Dual operator-(Dual a, const Dual &b)
+    {
+        return a -= b;
+    }
+
+    friend Dual operator*(Dual a, const Dual &b)
+    {
+        return a *= b;
+    }
+
+    friend Dual operator/(Dual a, const Dual &b)
+    {
+        return a /= b;
+    }
+
+    friend bool operator==(const Dual &a, const Dual &b)
+    {
+        return a._value == b._value && a._derivative == b._derivative;
+    }
+
+    friend bool operator!=(const Dual &a, const Dual &b)
+    {
+        return !(a == b);
+    }
+
+    /**
+     * @brief 자연로그를 구한다
+     * @param a 진수
+     * @return ln a
+     */
+    friend Dual log(const Dual &a)
+    {
+        using std::log;
+
+        return Dual(log(a._value), a._derivative / a._value);
+    }
+
+    /**
+     * @brief 거듭제곱을 구한다
+     * @param a 밑
+     * @param b 지수
+     * @return a^b
+     * @remark 미분값이 0 인 쪽의 항은 계산하지 않으므로, 상수 지수이면
+     *         음수 밑에서도 로그를 구하지 않는다
+     */
+    friend Dual pow(const Dual &a, const Dual &b)
+    {
+        using std::log;
+        using std::pow;
+
+        T p = pow(a._value, b._value);
+        T d = T(0);
+
+        // (a^b)' = b a^(b-1) a' + a^b ln(a) b'
+        if (a._derivative != T(0))
+            d += b._value * pow(a._value, b._value - T(1)) * a._derivative;
+
+        if (b._derivative != T(0))
+            d += p * log(a._value) * b._derivative;
+
+        return Dual(p, d);
+    }
+
+private:
+    T _value;       ///< 값
+    T _derivative;  ///< 미분값
+};
+
+#endif // DUAL_H
@@ -0,0 +1,620 @@
+/****************************************************************************
+**
+** graphrenderer.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#include "graphrenderer.h"
+
+#include <QPainter>
+#include <QtMath>
+
+namespace {
+
+/**
+ * @brief 두 곡선 표본이 같은 모양으로 그려지는지 알려준다
+ * @param a 곡선 표본
+ * @param b 곡선 표본
+ * @return 표본과 근, 극값이 모두 같으면 true, 아니면 false
+ */
+bool sameCurve(const CurveSamples &a, const CurveSamples &b)
+{
+    if (a.derivative != b.derivative || a.xs != b.xs || a.ys != b.ys
+            || a.points.size() != b.points.size())
+        return false;
+
+    for (int i = 0; i < a.points.size(); ++i)
+    {
+        const CurvePoint &p = a.points.at(i);
+        const CurvePoint &q = b.points.at(i);
+
+        if (p.kind != q.kind || p.x != q.x || p.y != q.y)
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief 픽셀 열마다 최솟값/최댓값 포락선만 남겨 점의 수를 줄인다
+ * @param points 화면 좌표의 점들. x 순서로 정렬되어 있어야 함
+ * @param dpr 장치 픽셀 비율
+ * @return 줄어든 점들
+ * @remark 한 장치 픽셀 열에 들어가는 점들 중 처음, 최소, 최대, 마지막
+ *         점만 원래 순서대로 남긴다. 그려지는 모양은 같으면서 점의 수는
+ *         표본 수와 관계없이 폭의 4 배를 넘지 않는다.
+ */
+QPolygonF GraphRenderer::decimate(const QPolygonF &points, qreal dpr)
+{
+    // 열마다 4 점보다 적으면 줄일 것이 없음
+    if (points.size() <= 4)
+        return points;
+
+    QPolygonF result;
+    int i = 0;
+
+    while (i < points.size())
+    {
+        int column = qFloor(points.at(i).x() * dpr);
+        int first = i;
+        int minIndex = i;
+        int maxIndex = i;
+
+        // 같은 열에 들어가는 점들 중 최소, 최대 찾기
+        for (++i; i < points.size()
+                  && qFloor(points.at(i).x() * dpr) == column; ++i)
+        {
+            if (points.at(i).y() < points.at(minIndex).y())
+                minIndex = i;
+
+            if (points.at(i).y() > points.at(maxIndex).y())
+                maxIndex = i;
+        }
+
+        int last = i - 1;
+
+        // 원래 순서대로, 겹치지 않게 추가
+        int indices[4] = {first, qMin(minIndex, maxIndex),
+                          qMax(minIndex, maxIndex), last};
+
+        for (int k = 0; k < 4; ++k)
+        {
+            if (k == 0 || indices[k] != indices[k - 1])
+                result.append(points.at(indices[k]));
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief GraphRenderer 생성자
+ */
+GraphRenderer::GraphRenderer()
+    : _axisFixed(false)
+    , _start(0)
+    , _end(0)
+    , _dpr(1)
+    , _yMin(0)
+    , _yMax(0)
+    , _layoutValid(false)
+    , _xScale(1)
+    , _yScale(1)
+    , _xOrg(0)
+    , _yOrg(0)
+    , _xStartPixel(0)
+    , _marksVisible(false)
+    , _layoutSerial(0)
+    , _layoutDpr(0)
+{
+}
+
+/**
+ * @brief 좌표축 고정 상태 설정
+ * @param fixed true 이면 고정되고, false 이면 고정되지 않음
+ */
+void GraphRenderer::setAxisFixed(bool fixed)
+{
+    _axisFixed = fixed;
+
+    // 배율과 원점이 바뀜. 바뀌지 않아도 좌표축은 다르게 그림
+    _layoutValid = false;
+    _axisLayer.serial = -1;
+}
+
+/**
+ * @brief 범위를 설정한다
+ * @param start 시작값
+ * @param end 끝값
+ * @remark 표본이 아니라 이 범위로 배율을 정하므로, 표본을 새로 계산하는
+ *         동안에는 이전 표본이 옮겨지거나 늘어난 채로 그려진다
+ */
+void GraphRenderer::setRange(double start, double end)
+{
+    _start = qMin(start, end);
+    _end = qMax(start, end);
+
+    _layoutValid = false;
+}
+
+/**
+ * @brief 그릴 크기를 설정한다
+ * @param size 논리 픽셀 단위의 크기
+ * @param devicePixelRatio 장치 픽셀 비율
+ */
+void GraphRenderer::setSize(const QSize &size, qreal devicePixelRatio)
+{
+    if (size == _size && devicePixelRatio == _dpr)
+        return;
+
+    _size = size;
+    _dpr = devicePixelRatio;
+
+    _layoutValid = false;
+}
+
+/**
+ * @brief 근과 극값 표시 여부를 설정한다
+ * @param visible true 이면 표시하고, false 이면 표시하지 않음
+ */
+void GraphRenderer::setMarksVisible(bool visible)
+{
+    _marksVisible = visible;
+
+    // 좌표축 층은 그대로 씀
+    for (int c = 0; c < _curveLayers.size(); ++c)
+        _curveLayers[c].serial = -1;
+}
+
+/**
+ * @brief 그릴 곡선 표본을 설정하고, 모든 곡선을 합친 y 범위를 구한다
+ * @param curves 곡선마다의 표본
+ * @remark y 범위는 추출기가 곡선마다 구해 둔 범위를 합친다. 표본이
+ *         바뀐 곡선의 층만 다시 그린다.
+ */
+void GraphRenderer::setCurves(const QVector<CurveSamples> &curves)
+{
+    _curveLayers.resize(curves.size());
+
+    for (int c = 0; c < curves.size(); ++c)
+    {
+        if (c >= _curves.size() || !sameCurve(curves.at(c), _curves.at(c)))
+            _curveLayers[c].serial = -1;
+    }
+
+    _curves = curves;
+
+    // 곡선마다 색깔 번호. 도함수 곡선은 바로 앞 함수의 색깔을 씀
+    _colors.resize(_curves.size());
+
+    int color = -1;
+
+    for (int c = 0; c < _curves.size(); ++c)
+    {
+        if (!_curves.at(c).derivative || color < 0)
+            ++color;
+
+        _colors[c] = color;
+    }
+
+    // 모든 곡선을 합친 최솟값과 최댓값 찾기
+    bool found = false;
+
+    foreach (const CurveSamples &curve, _curves)
+    {
+        if (!curve.hasRange)
+            continue;
+
+        _yMin = found ? qMin(_yMin, curve.yMin) : curve.yMin;
+        _yMax = found ? qMax(_yMax, curve.yMax) : curve.yMax;
+        found = true;
+    }
+
+    if (!found)
+        _yMin = _yMax = 0;
+
+    // 상수 함수에 대한 보정
+    if (_yMax == _yMin)
+    {
+        if (_yMax == 0)
+        {
+            _yMax = 10;
+            _yMin = -10;
+        }
+        else
+        {
+            _yMax = qAbs(_yMax);
+            _yMin = -_yMax;
+        }
+    }
+
+    // 표본이 바뀌었으므로 배율도 다시 계산
+    _layoutValid = false;
+}
+
+/**
+ * @brief 수평 배율을 돌려준다
+ * @return 한 x 값 단위의 논리 픽셀 수
+ */
+double GraphRenderer::xScale()
+{
+    if (!_layoutValid)
+        updateLayout();
+
+    return _xScale;
+}
+
+/**
+ * @brief 논리 픽셀 위치의 x 값을 구한다
+ * @param x 논리 픽셀 단위의 수평 위치
+ * @return x 값
+ */
+double GraphRenderer::valueAt(qreal x)
+{
+    if (!_layoutValid)
+        updateLayout();
+
+    return _start + (x - _xStartPixel) / _xScale;
+}
+
+/**
+ * @brief 좌표축과 곡선을 그린다
+ * @param painter 그릴 QPainter
+ */
+void GraphRenderer::paint(QPainter *painter)
+{
+    // 아직 계산된 표본이 없음
+    if (_curves.isEmpty())
+        return;
+
+    if (!_layoutValid)
+        updateLayout();
+
+    paintAxes(painter);
+
+    for (int c = 0; c < _segments.size(); ++c)
+        paintCurve(painter, c);
+}
+
+/**
+ * @brief 층마다 캐시한 픽스맵을 겹쳐 그린다
+ * @param painter 그릴 QPainter
+ * @remark 좌표축 층과 곡선마다의 층을 따로 캐시하고, 입력이 바뀐 층만
+ *         다시 그린다. 배율이나 원점이 바뀌면 모든 층을 다시 그린다.
+ *         QPixmap 을 쓰므로 GUI 스레드에서만 부를 수 있다.
+ */
+void GraphRenderer::paintLayers(QPainter *painter)
+{
+    // 아직 계산된 표본이 없음
+    if (_curves.isEmpty())
+        return;
+
+    if (!_layoutValid)
+        updateLayout();
+
+    if (_axisLayer.serial != _layoutSerial)
+    {
+        QPainter layerPainter(beginLayer(&_axisLayer));
+
+        paintAxes(&layerPainter);
+    }
+
+    for (int c = 0; c < _curveLayers.size(); ++c)
+    {
+        if (_curveLayers.at(c).serial != _layoutSerial)
+        {
+            QPainter layerPainter(beginLayer(&_curveLayers[c]));
+
+            paintCurve(&layerPainter, c);
+        }
+    }
+
+    // 좌표축 위에 곡선을 차례로 겹침
+    painter->drawPixmap(0, 0, _axisLayer.pixmap);
+
+    foreach (const Layer &layer, _curveLayers)
+        painter->drawPixmap(0, 0, layer.pixmap);
+}
+
+/**
+ * @brief 층을 다시 그릴 수 있게 비운다
+ * @param layer 다시 그릴 층
+ * @return 층의 픽스맵
+ */
+QPixmap *GraphRenderer::beginLayer(Layer *layer)
+{
+    QSize pixels = _size * _dpr;
+
+    if (layer->pixmap.size() != pixels)
+        layer->pixmap = QPixmap(pixels);
+
+    layer->pixmap.setDevicePixelRatio(_dpr);
+    layer->pixmap.fill(Qt::transparent);
+    layer->serial = _layoutSerial;
+
+    return &layer->pixmap;
+}
+
+/**
+ * @brief 좌표축을 그린다
+ * @param painter 그릴 QPainter
+ */
+void GraphRenderer::paintAxes(QPainter *painter)
+{
+    painter->save();
+
+    // 수직 원점 변경, x 축 대칭. 수평 위치는 점마다 계산되어 있음
+    painter->translate(0, _yOrg);
+    painter->scale(1, -1);
+
+    // 좌표축의 색깔은 검은색
+    painter->setPen(Qt::black);
+
+    if (_axisFixed) // 좌표축이 고정되어 있으면
+    {
+        // 중심에 좌표축 그림
+        painter->drawLine(QLineF(0, 0, 2 * _xOrg, 0));
+        painter->drawLine(QLineF(_xOrg, -_yOrg, _xOrg, _yOrg));
+    }
+    else            // 좌표축이 고정되어 있지 않으면
+    {
+        // 실제 그래프에 따라 좌표축 그림. y 축은 보일 때만
+        painter->drawLine(QLineF(_xStartPixel, 0,
+                                 _xStartPixel + (_end - _start) * _xScale, 0));
+
+        if (_xOrg >= 0 && _xOrg <= _size.width())
+            painter->drawLine(QLineF(_xOrg, _yMin * _yScale,
+                                     _xOrg, _yMax * _yScale));
+    }
+
+    painter->restore();
+}
+
+/**
+ * @brief 곡선 하나를 그린다
+ * @param painter 그릴 QPainter
+ * @param c 곡선 번호
+ */
+void GraphRenderer::paintCurve(QPainter *painter, int c)
+{
+    // 그래프의 색깔은 빨간색부터 차례로 돌아가며 씀. 도함수 곡선은 바로
+    // 앞 함수의 색깔로 점선을 그림
+    static const Qt::GlobalColor colors[] = {
+        Qt::red, Qt::blue, Qt::darkGreen, Qt::magenta,
+        Qt::darkCyan, Qt::darkYellow, Qt::darkRed, Qt::darkBlue
+    };
+    const int colorCount = sizeof(colors) / sizeof(colors[0]);
+
+    const CurveSamples &curve = _curves.at(c);
+
+    painter->save();
+
+    // 수직 원점 변경, x 축 대칭. 수평 위치는 점마다 계산되어 있음
+    painter->translate(0, _yOrg);
+    painter->scale(1, -1);
+
+    QPen pen(colors[_colors.at(c) % colorCount]);
+
+    if (curve.derivative)
+        pen.setStyle(Qt::DashLine);
+
+    painter->setPen(pen);
+
+    // 캐시된 점들을 불연속점 사이마다 한 번에 이음
+    foreach (const QPolygonF &segment, _segments.at(c))
+        painter->drawPolyline(segment);
+
+    if (_marksVisible)
+        paintMarks(painter, curve);
+
+    painter->restore();
+}
+
+/**
+ * @brief 곡선의 근과 극값을 표시한다
+ * @param painter 그릴 QPainter. 곡선의 색깔이 설정되어 있어야 함
+ * @param curve 곡선 표본
+ * @remark 근은 빈 원으로, 극값은 채운 원으로 표시한다
+ */
+void GraphRenderer::paintMarks(QPainter *painter, const CurveSamples &curve)
+{
+    const qreal radius = 3;
+
+    QPen pen(painter->pen().color());
+
+    painter->setPen(pen);
+
+    foreach (const CurvePoint &point, curve.points)
+    {
+        QPointF center(_xStartPixel + (point.x - _start) * _xScale,
+                       point.y * _yScale);
+
+        if (point.kind == CurvePoint::Root)
+            painter->setBrush(Qt::NoBrush);
+        else
+            painter->setBrush(pen.color());
+
+        painter->drawEllipse(center, radius, radius);
+    }
+
+    painter->setBrush(Qt::NoBrush);
+}
+
+/**
+ * @brief 다항식들을 계산해 이미지로 그린다
+ * @param polys 함께 그릴 다항식들
+ * @param start 시작값
+ * @param end 끝값
+ * @param size 논리 픽셀 단위의 크기
+ * @param axisFixed 좌표축 고정 여부
+ * @param devicePixelRatio 장치 픽셀 비율
+ * @param precision 계산 정밀도
+ * @param derivatives true 이면 도함수 곡선을 함께 그림
+ * @param marks true 이면 근과 극값을 표시
+ * @return 그려진 이미지
+ * @remark 창 시스템 없이 어느 스레드에서나 부를 수 있다
+ */
+QImage GraphRenderer::render(const QStringList &polys,
+                             double start, double end,
+                             const QSize &size, bool axisFixed,
+                             qreal devicePixelRatio,
+                             PolyCalc::Precision precision,
+                             bool derivatives, bool marks)
+{
+    QVector<PolyCalc> polyCalcs;
+
+    foreach (const QString &poly, polys)
+        polyCalcs.append(PolyCalc(poly));
+
+    AdaptiveSampler sampler(polyCalcs);
+
+    sampler.setPrecision(precision);
+    sampler.setDerivatives(derivatives);
+    sampler.setMarks(marks);
+
+    GraphRenderer renderer;
+
+    renderer.setAxisFixed(axisFixed);
+    renderer.setMarksVisible(marks);
+    renderer.setRange(start, end);
+    renderer.setSize(size, devicePixelRatio);
+    renderer.setCurves(sampler.sample(renderer.start(), renderer.end(),
+                                      qRound(size.width() * devicePixelRatio),
+                                      qRound(size.height()
+                                             * devicePixelRatio)));
+
+    QImage image(size * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+
+    image.setDevicePixelRatio(devicePixelRatio);
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+
+    renderer.paint(&painter);
+
+    return image;
+}
+
+/**
+ * @brief 배율과 원점을 계산하고, 그릴 점들을 만든다
+ */
+void GraphRenderer::updateLayout()
+{
+    double oldXScale = _xScale;
+    float oldYScale = _yScale;
+    qreal oldXOrg = _xOrg;
+    int oldYOrg = _yOrg;
+    qreal oldXStartPixel = _xStartPixel;
+
+    double xStart = _start;
+    double xEnd = _end;
+
+    int w = _size.width() - 1;  // 실제로 그릴 수 있는 폭
+    int h = _size.height() - 1; // 실제로 그릴 수 있는 높이
+
+    if (_axisFixed)         // 좌표축이 고정되어 있으면,
+    {
+        // 중심을 기준으로 배율 계산
+        _xScale = (w / 2) / qMax(qAbs(xStart), qAbs(xEnd));
+        _yScale = (h / 2) / qMax(qAbs(_yMin), qAbs(_yMax));
+
+        // 중심이 원점
+        _xOrg = w / 2;
+        _yOrg = h / 2;
+    }
+    else                    // 좌표축이 고정되어 있지 않으면
+    {
+        // 수평 배율 계산
+        if (xEnd * xStart < 0 )
+            _xScale = w * (xStart / (xEnd - xStart)) / xStart;
+        else
+            _xScale = w / (xEnd - xStart);
+
+        // 수직 배율 계산
+        if (_yMax * _yMin < 0)
+            _yScale = h * (_yMin / (_yMax - _yMin)) / _yMin;
+        else
+            _yScale = h / (_yMax - _yMin);
+
+        // 실제 그래프에 따라 원점 설정
+        _xOrg = -xStart * _xScale;
+        _yOrg = _yMax * _yScale;
+    }
+
+    // 넓은 범위에서도 위치를 잃지 않도록 점은 시작값에서 떨어진 거리로
+    // 계산함
+    _xStartPixel = _axisFixed ? _xOrg + xStart * _xScale : 0;
+
+    // 배율이나 원점, 크기가 바뀌었으면 모든 층을 다시 그림
+    bool moved = _xScale != oldXScale || _yScale != oldYScale
+                 || _xOrg != oldXOrg || _yOrg != oldYOrg
+                 || _xStartPixel != oldXStartPixel
+                 || _size != _layoutSize || _dpr != _layoutDpr;
+
+    if (moved)
+        _layoutSerial++;
+
+    _layoutSize = _size;
+    _layoutDpr = _dpr;
+
+    // 배율을 적용한 점들을 불연속점에서 나누고, 픽셀 열마다 줄임. 그대로인
+    // 층의 점들은 다시 만들지 않음
+    _segments.resize(_curves.size());
+
+    for (int c = 0; c < _curves.size(); ++c)
+    {
+        if (moved || _curveLayers.at(c).serial != _layoutSerial)
+            _segments[c] = segmentsOf(_curves.at(c));
+    }
+
+    _layoutValid = true;
+}
+
+/**
+ * @brief 곡선 표본에 배율을 적용해 불연속점 사이의 구간들로 나눈다
+ * @param curve 곡선 표본
+ * @return 픽셀 열마다 줄인 연속 구간들
+ */
+QVector<QPolygonF> GraphRenderer::segmentsOf(const CurveSamples &curve) const
+{
+    QVector<QPolygonF> segments;
+    QPolygonF segment;
+
+    for (int i = 0; i < curve.xs.size(); ++i)
+    {
+        float y = curve.ys.at(i);
+
+        if (qIsFinite(y))
+            segment.append(QPointF(_xStartPixel
+                                   + (curve.xs.at(i) - _start) * _xScale,
+                                   y * _yScale));
+        else if (!segment.isEmpty())
+        {
+            segments.append(decimate(segment, _dpr));
+            segment.clear();
+        }
+    }
+
+    if (!segment.isEmpty())
+        segments.append(decimate(segment, _dpr));
+
+    return segments;
+}
@@ -0,0 +1,189 @@
+/****************************************************************************
+**
+** graphrenderer.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef GRAPHRENDERER_H
+#define GRAPHRENDERER_H
+
+#include "sampler.h"
+
+#include <QImage>
+#include <QPixmap>
+#include <QPolygonF>
+#include <QSize>
+#include <QStringList>
+#include <QVector>
+
+class QPainter;
+
+/**
+ * @brief 그래프 렌더러
+ *
+ * 곡선 표본으로부터 배율과 원점을 계산하고, 좌표축과 곡선을 그린다.
+ * 위젯과 관계없이 QPainter 만 쓰므로, 화면이 없어도 QImage 에 그릴 수 있다.
+ * 배율과 그릴 점들은 캐시해 두고, 크기나 범위, 표본이 바뀔 때만 다시
+ * 계산한다.
+ *
+ * 화면에 그릴 때는 좌표축과 곡선마다 층을 나누어 픽스맵에 캐시하고 겹쳐
+ * 그린다. 배율이 그대로이면 표본이 바뀐 곡선의 층만 다시 그리므로, 곡선을
+ * 하나 더하거나 근과 극값 표시를 바꾸어도 장면 전체를 다시 그리지 않는다.
+ */
+class GraphRenderer
+{
+public:
+    GraphRenderer();
+
+    void setAxisFixed(bool fixed);
+
+    /**
+     * @brief 좌표축 고정 상태를 돌려준다
+     * @return 좌표축이 고정되어 있으면 true, 아니면 false
+     */
+    bool axisFixed() const
+    {
+        return _axisFixed;
+    }
+
+    void setRange(double start, double end);
+
+    /**
+     * @brief 시작값을 돌려준다
+     * @return 시작값
+     */
+    double start() const
+    {
+        return _start;
+    }
+
+    /**
+     * @brief 끝값을 돌려준다
+     * @return 끝값
+     */
+    double end() const
+    {
+        return _end;
+    }
+
+    void setSize(const QSize &size, qreal devicePixelRatio = 1);
+
+    /**
+     * @brief 논리 픽셀 단위의 크기를 돌려준다
+     * @return 크기
+     */
+    QSize size() const
+    {
+        return _size;
+    }
+
+    void setMarksVisible(bool visible);
+
+    /**
+     * @brief 근과 극값 표시 여부를 돌려준다
+     * @return 표시하면 true, 아니면 false
+     */
+    bool marksVisible() const
+    {
+        return _marksVisible;
+    }
+
+    void setCurves(const QVector<CurveSamples> &curves);
+
+    /**
+     * @brief 곡선마다의 표본을 돌려준다
+     * @return 곡선 표본들
+     */
+    const QVector<CurveSamples> &curves() const
+    {
+        return _curves;
+    }
+
+    /**
+     * @brief 그릴 곡선이 없는지 알려준다
+     * @return 곡선이 없으면 true, 아니면 false
+     */
+    bool isEmpty() const
+    {
+        return _curves.isEmpty();
+    }
+
+    double xScale();
+    double valueAt(qreal x);
+
+    void paint(QPainter *painter);
+    void paintLayers(QPainter *painter);
+
+    static QImage render(const QStringList &polys, double start, double end,
+                         const QSize &size, bool axisFixed = false,
+                         qreal devicePixelRatio = 1,
+                         PolyCalc::Precision precision
+                                = PolyCalc::AutoPrecision,
+                         bool derivatives = false, bool marks = false);
+
+    static QPolygonF decimate(const QPolygonF &points, qreal dpr);
+
+private:
+    /**
+     * @brief 캐시된 층
+     */
+    struct Layer
+    {
+        QPixmap pixmap; ///< 그려진 층
+        int serial;     ///< 그릴 때의 배치 번호. 다르면 다시 그려야 함
+
+        Layer() : serial(-1) {}
+    };
+
+    bool _axisFixed;    ///< 좌표축 고정 상태
+    double _start;      ///< 시작값
+    double _end;        ///< 끝값
+    QSize _size;        ///< 논리 픽셀 단위의 크기
+    qreal _dpr;         ///< 장치 픽셀 비율
+
+    QVector<CurveSamples> _curves;  ///< 그릴 곡선마다의 표본
+    float _yMin;        ///< y 최솟값
+    float _yMax;        ///< y 최댓값
+
+    bool _layoutValid;  ///< 배율/원점 캐시가 유효한지 여부
+    double _xScale;     ///< 수평 배율
+    float _yScale;      ///< 수직 배율
+    qreal _xOrg;        ///< x 축 원점. 화면에서 아주 멀 수 있음
+    int _yOrg;          ///< y 축 원점
+    qreal _xStartPixel; ///< 시작값의 수평 위치
+    QVector<QVector<QPolygonF> > _segments; ///< 곡선마다 배율이 적용된
+                                            ///< 연속 구간들
+    bool _marksVisible; ///< 근과 극값 표시 여부
+    QVector<int> _colors;   ///< 곡선마다 색깔 번호
+
+    int _layoutSerial;  ///< 배율이나 원점이 바뀔 때마다 늘어나는 배치 번호
+    QSize _layoutSize;  ///< 배치를 계산할 때의 크기
+    qreal _layoutDpr;   ///< 배치를 계산할 때의 장치 픽셀 비율
+    Layer _axisLayer;   ///< 좌표축 층
+    QVector<Layer> _curveLayers;    ///< 곡선마다의 층
+
+    void updateLayout();
+    QVector<QPolygonF> segmentsOf(const CurveSamples &curve) const;
+    QPixmap *beginLayer(Layer *layer);
+    void paintAxes(QPainter *painter);
+    void paintCurve(QPainter *painter, int c);
+    void paintMarks(QPainter *painter, const CurveSamples &curve);
+};
+
+#endif // GRAPHRENDERER_H
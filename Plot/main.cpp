@@ -21,13 +21,31 @@
 ****************************************************************************/
 
 #include "plot.h"
+#include "plotcli.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // 명령행 모드는 창 시스템 없이 실행
+    if (PlotCli::isRequested(argc, argv))
+    {
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+
+        QGuiApplication a(argc, argv);
+
+        return PlotCli().exec(a.arguments());
+    }
+
     QApplication a(argc, argv);
     Plot w;
     w.show();
 
+    // '--data 파일' 이면 실시간 데이터를 그림. '-' 는 표준 입력
+    int data = a.arguments().indexOf("--data");
+
+    if (data > 0 && data + 1 < a.arguments().size())
+        w.openDataSource(a.arguments().at(data + 1));
+
     return a.exec();
 }
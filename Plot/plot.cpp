@@ -21,522 +21,521 @@
 ****************************************************************************/
 
 #include "plot.h"
+#include "polycalc.h"
+#include "datasource.h"
+#include "graphrenderer.h"
+#include "sampler.h"
+#include "seriesrenderer.h"
+
+#include <QtConcurrent>
+
+#include <cmath>
 
 /**
- * @brief 다항식 계산기
+ * @brief 그래프 위젯
+ *
+ * 표본 값과 화면 배율을 캐시해 두고, 입력이 바뀔 때만 다시 계산한다.
+ * 단순히 다시 그릴 때는 캐시된 점들을 한 번에 그린다. 그리기는
+ * GraphRenderer 가 맡는다.
+ *
+ * 표본은 스레드 풀에서 계산하므로 GUI 가 멈추지 않는다. 계산하는 동안에는
+ * 이전 표본을 그리고, 계산이 끝나면 다시 그린다.
+ *
+ * 마우스 휠로 확대/축소하고, 끌어서 화면을 옮길 수 있다. 계산한 표본은
+ * 확대 단계와 타일 번호로 캐시해 두므로, 새로 드러난 타일만 계산한다.
+ *
+ * 여러 다항식을 한꺼번에 그릴 수 있다. 모든 곡선은 같은 표본 격자와
+ * 배율을 쓰고, 곡선마다 다른 색으로 그린다.
+ *
+ * 범위는 double 로 가지므로, float 로는 구별할 수 없는 깊이까지 확대할 수
+ * 있다. 그런 곳에서는 추출기가 더 넓은 형으로 계산한다.
+ *
+ * 데이터 원본을 주면 다항식 대신 실시간 데이터를 그린다. 들어온 점은
+ * SeriesRenderer 가 픽스맵에 이어 그리므로, 다시 그릴 때는 픽스맵만 옮긴다.
  */
-class PolyCalc
+class GraphWidget : public QWidget
 {
+    Q_OBJECT
+
 public:
     /**
-     * @brief PolyCalc 생성자
-     * @param 다항식
+     * @brief GraphWidget 생성자
+     * @param parent 부모 위젯
      */
-    explicit PolyCalc(const QString &poly)
-        : _poly(poly)
-        , _pos(0)
-        , _x(0)
+    GraphWidget(QWidget *parent = 0)
+            : QWidget(parent)
+            , _generation(0)
+            , _samplesGeneration(-1)
+            , _tileCache(MaxCachedSamples)
+            , _cacheGeneration(0)
+            , _jobCacheGeneration(0)
+            , _source(0)
+            , _dragging(false)
+            , _dragStart(0)
+            , _dragEnd(0)
+            , _dragScale(1)
     {
+        connect(&_watcher, SIGNAL(finished()), this, SLOT(samplesReady()));
     }
 
     /**
-     * @brief x 값을 설정한다
-     * @param x x 로 설정할 값
+     * @brief 좌표축 고정 상태 설정
+     * @param fixed true 이면 고정되고, false 이면 고정되지 않음
      */
-    void setX(float x)
+    void setAxisFixed(bool fixed)
     {
-        _x = x;
+        _renderer.setAxisFixed(fixed);
     }
 
     /**
-     * @brief 다항식을 계산한다
-     * @return 계산 결과를 돌려준다
+     * @brief 다항식들을 설정한다
+     * @param polys 함께 그릴 다항식들
      */
-    float calc()
+    void setPolys(const QStringList &polys)
     {
-        _pos = 0;
+        // 같은 다항식들이면 캐시된 타일을 그대로 씀
+        if (polys == _polys)
+            return;
 
-        return level1();
-    }
+        _polys = polys;
 
-private:
-    QString _poly;  ///< 다항식
-    int _pos;       ///< 현재 파싱 위치
-    float _x;       ///< x 값
+        // 다항식은 여기서 한 번만 컴파일됨
+        QVector<PolyCalc> polyCalcs;
+
+        foreach (const QString &poly, polys)
+            polyCalcs.append(PolyCalc(poly));
+
+        _sampler.setPolyCalcs(polyCalcs);
+
+        // 다른 다항식의 타일은 쓸 수 없음
+        clearTileCache();
+
+        _generation++;
+    }
 
     /**
-     * @brief 토큰을 읽지만, 파싱 위치 바꾸지 않는다
-     * @return 현재 토큰
+     * @brief 실시간 데이터 원본을 설정한다
+     * @param source 데이터 원본. 위젯이 소유하며, 설정한 뒤에 읽기를
+     *               시작해야 함. 0 이면 다시 다항식을 그림
      */
-    inline QString peekToken()
+    void setDataSource(DataSource *source)
     {
-        return token(false);
+        delete _source;
+
+        _source = source;
+        _series.clear();
+
+        if (_source)
+        {
+            _source->setParent(this);
+
+            connect(_source, SIGNAL(dataAvailable()),
+                    this, SLOT(dataAvailable()));
+        }
+
+        update();
     }
 
     /**
-     * @brief 토큰을 읽고, 파싱 위치를 바꾼다
-     * @return 현재 토큰
+     * @brief 범위를 설정한다
+     * @param start 시작값
+     * @param end 끝값
      */
-    inline QString nextToken()
+    void setRange(double start, double end)
     {
-        return token(true);
+        // 이전 표본을 새 범위에 맞추어 옮겨 그림
+        _renderer.setRange(start, end);
+
+        _generation++;
     }
 
     /**
-     * @brief 부호를 읽는다
-     * @return 현재 토큰이 - 부호이면 -1, 아니면 1 을 돌려준다
-     * @remark 부호를 읽었으면 파싱 위치를 옮기고, 아니면 옮기지 않는다
+     * @brief 표본 추출의 허용 오차를 설정한다
+     * @param pixels 픽셀 단위의 허용 오차
      */
-    inline float getSign()
+    void setErrorBound(float pixels)
     {
-        QChar sign('+');
-        QString tok;
+        _sampler.setErrorBound(pixels);
 
-        // 연속된 부호 허용
-        while(( tok = peekToken()) == "+" || tok == "-")
-        {
-            nextToken();
-
-            if( sign == tok.at(0))
-                sign = '+';
-            else
-                sign = '-';
-        }
+        // 나눈 표본이 허용 오차에 따라 다름
+        clearTileCache();
 
-        return sign == '+' ? 1 : -1;
+        _generation++;
     }
 
     /**
-     * @brief 현재 토큰이 숫자인지 알려준다
-     * @return 현재 토큰이 숫자이면 true, 아니면 false 를 돌려준다.
-     * @remark 숫자를 읽었으면 파싱 위치를 옮기고, 아니면 옮기지 않는다.
+     * @brief 계산 정밀도를 설정한다
+     * @param precision 계산 정밀도
      */
-    inline bool isNumber()
+    void setPrecision(PolyCalc::Precision precision)
     {
-        bool ok;
+        if (precision == _sampler.precision())
+            return;
+
+        _sampler.setPrecision(precision);
 
-        peekToken().toFloat(&ok);
+        // 표본 값이 정밀도에 따라 다름
+        clearTileCache();
 
-        return ok;
+        _generation++;
     }
 
     /**
-     * @brief 수를 읽는다
-     * @return 현재 토큰이 숫자이면, 해당 숫자를 돌려주고, 아니면 0 을 돌려준다.
-     * @remark 숫자를 읽었으면 파싱 위치를 옮기고, 아니면 옮기지 않는다.
+     * @brief 도함수 곡선을 함께 그릴지 설정한다
+     * @param visible true 이면 그리고, false 이면 그리지 않음
      */
-    inline float getNumber()
+    void setDerivativesVisible(bool visible)
     {
-        bool ok;
-        float num = peekToken().toFloat(&ok);
-        if (ok)
-            nextToken();
-        else
-            num = 0;
-
-        return num;
+        if (visible == _sampler.derivatives())
+            return;
+
+        _sampler.setDerivatives(visible);
+
+        // 타일마다 가진 곡선 수가 달라짐
+        clearTileCache();
+
+        _generation++;
     }
 
     /**
-     * @brief 토큰을 읽는다
-     * @param next true 이면 파싱 위치를 바꾸고, false 이면 바꾸지 않는다
-     * @return 현재 토큰
+     * @brief 근과 극값 표시 여부를 설정한다
+     * @param visible true 이면 표시하고, false 이면 표시하지 않음
      */
-    QString token(bool next)
+    void setMarksVisible(bool visible)
     {
-        // 현재 위치 저장
-        int savedPos = _pos;
+        _renderer.setMarksVisible(visible);
 
-        QString result;
+        if (visible == _sampler.marks())
+            return;
 
-        // 공백 문자 무시
-        while (_pos < _poly.length() && _poly.at(_pos).isSpace())
-            _pos++;
+        _sampler.setMarks(visible);
 
-        if (_pos < _poly.length())
-        {
-            QChar ch = _poly.at(_pos++);
+        // 다항식이 아닌 식의 근과 극값은 켤 때만 찾으므로 타일을 다시 계산
+        clearTileCache();
 
-            if (ch.isNumber())
-            {
-                // 숫자 파싱
-                do
-                {
-                    result.append(ch);
+        _generation++;
+    }
 
-                    if (_pos >= _poly.length())
-                        break;
+signals:
+    /**
+     * @brief 확대/축소하거나 화면을 옮겨 범위가 바뀌었을 때 발생한다
+     * @param start 시작값
+     * @param end 끝값
+     */
+    void rangeChanged(double start, double end);
 
-                    ch = _poly.at(_pos++);
-                } while (ch.isNumber());
+protected:
+    /**
+     * @brief 위젯 크기가 바뀔 때 호출된다
+     * @param e 크기 변경 이벤트
+     */
+    void resizeEvent(QResizeEvent *e)
+    {
+        // 픽셀 수에 맞추어 표본을 뽑으므로 표본도 다시 계산
+        _generation++;
 
-                if (!ch.isNumber())
-                    _pos--;
-            }
-            else if (ch.isLetter())
-            {
-                // 문자 파싱
-                do
-                {
-                    result.append(ch);
+        QWidget::resizeEvent(e);
+    }
 
-                    if (_pos >= _poly.length())
-                        break;
+    /**
+     * @brief 위젯 내부를 그린다
+     */
+    void paintEvent(QPaintEvent */*e*/)
+    {
+        // 실시간 데이터는 새 점만 이어 그린 픽스맵을 그림
+        if (_source)
+        {
+            _series.setSize(size(), devicePixelRatioF());
 
-                    ch = _poly.at(_pos++);
-                } while (ch.isLetter());
+            QPainter painter(this);
 
-                if (!ch.isLetter())
-                    _pos--;
-            }
-            else
-            {
-                // 나머지는 그대로 추가
-                result.append(ch);
-            }
+            _series.paint(&painter);
+
+            return;
         }
 
-        // peek 모드이면 파싱 위치 복원
-        if (!next)
-            _pos = savedPos;
+        if (_polys.isEmpty())
+            return;
+
+        // 입력이 바뀌었으면 표본 계산 시작
+        startSampling();
 
-        // x 대체
-        if (result == "x")
-            result = QString::number(_x);
+        _renderer.setSize(size(), devicePixelRatioF());
+
+        QPainter painter(this);
 
-        return result;
+        // 입력이 바뀐 층만 다시 그리고 겹침
+        _renderer.paintLayers(&painter);
     }
 
     /**
-     * @brief 더하기/빼기를 계산한다
-     * @return 계산 결과를 돌려준다
+     * @brief 마우스 휠을 돌릴 때 호출된다
+     * @param e 휠 이벤트
+     * @remark 커서 아래의 x 값을 중심으로, 한 칸에 한 확대 단계씩
+     *         확대/축소한다
      */
-    float level1()
+    void wheelEvent(QWheelEvent *e)
     {
-        float res = 0;
-        QString op(peekToken());
+        double oldStart = _renderer.start();
+        double oldEnd = _renderer.end();
 
-        do
+        if (_source || _renderer.isEmpty() || oldEnd <= oldStart)
         {
-            if (op == "+" || op == "-")
-            {
-                nextToken();
+            e->ignore();
 
-                // 오른쪽 값 계산
-                float rv = level2();
+            return;
+        }
 
-                // 더하기/빼기 수행
-                if (op == "+")
-                    res += rv;
-                else /*if (op == "-") */
-                    res -= rv;
-            }
-            else if (!op.isEmpty()) // 더하기/빼기가 아니면
-                res = level2();     // 더 높은 우선순위로 넘김
+        // 휠 한 칸은 120, 확대 단계 하나는 2^(1/4) 배
+        double factor = std::exp2(-e->angleDelta().y() / 120.0 / 4);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        double x = _renderer.valueAt(e->position().x());
+#else
+        double x = _renderer.valueAt(e->pos().x());
+#endif
+        double start = x - (x - oldStart) * factor;
+        double end = x + (oldEnd - x) * factor;
+
+        // double 로 픽셀을 구별할 수 없을 만큼 좁거나, 타일 번호가 넘칠
+        // 만큼 넓어지지 않게 함
+        double limit = qMax(qAbs(start), qAbs(end));
 
-            // 더하기/빼기가 이어지면 계속 계산
-            op = peekToken();
-        } while (op == "+" || op == "-");
+        if (end - start > limit * 1e-10 && limit < 1e30)
+            changeRange(start, end);
 
-        return res;
+        e->accept();
     }
 
     /**
-     * @brief 곱하기/나누기를 계산한다
-     * @return 계산 결과를 돌려준다
+     * @brief 마우스 단추를 누를 때 호출된다
+     * @param e 마우스 이벤트
      */
-    float level2()
+    void mousePressEvent(QMouseEvent *e)
     {
-        float res;
-        QString op(peekToken());
-
-        do
+        if (e->button() != Qt::LeftButton || _source || _renderer.isEmpty())
         {
-            if (op == "*" || op == "/")
-            {
-                nextToken();
+            QWidget::mousePressEvent(e);
 
-                // 오른쪽 값 계산
-                float rv = level3();
-
-                // 곱하기/나누기 수행
-                if (op == "*")
-                    res *= rv;
-                else /*if (op == "/") */
-                    res /= rv;
-            }
-            else if (!op.isEmpty()) // 곱하기/나누기가 아니면
-                res = level3();    // 더 높은 우선 순위로 넘김
+            return;
+        }
 
-            // 곱하기/나누기가 이어지면 계속 계산
-            op = peekToken();
-        } while (op == "*" || op == "/");
+        // 끄는 동안에는 누를 때의 범위와 배율을 기준으로 옮김
+        _dragging = true;
+        _dragPos = e->pos();
+        _dragStart = _renderer.start();
+        _dragEnd = _renderer.end();
+        _dragScale = _renderer.xScale();
 
-        return res;
+        setCursor(Qt::ClosedHandCursor);
     }
 
     /**
-     * @brief 거듭제곱을 계산한다
-     * @return 계산결과를 돌려준다
+     * @brief 마우스를 움직일 때 호출된다
+     * @param e 마우스 이벤트
      */
-    float level3()
+    void mouseMoveEvent(QMouseEvent *e)
     {
-        float res;
-        QString op(peekToken());
-
-        do
+        if (!_dragging)
         {
-            if (op == "^")
-            {
-                nextToken();
-
-                // 오른쪽 값 계산
-                float rv = level4();
+            QWidget::mouseMoveEvent(e);
 
-                // 거듭제곱 수행
-                res = pow(res, rv);
-            }
-            else if (!op.isEmpty()) // 거듭제곱이 아니면
-                res = level4();    // 더 높은 우선 순위로 넘김
+            return;
+        }
 
-            // 거듭제곱이 이어지면 계속 계산
-            op = peekToken();
-        } while (op == "^");
+        double dx = (e->pos().x() - _dragPos.x()) / _dragScale;
 
-        return res;
+        changeRange(_dragStart - dx, _dragEnd - dx);
     }
 
     /**
-     * @brief 괄호를 계산한다
-     * @return 계산 결과를 돌려준다
+     * @brief 마우스 단추를 놓을 때 호출된다
+     * @param e 마우스 이벤트
      */
-    float level4()
+    void mouseReleaseEvent(QMouseEvent *e)
     {
-        float res;
-        QString op(peekToken());
-
-        if (op == "(")
+        if (!_dragging || e->button() != Qt::LeftButton)
         {
-            nextToken();
-
-            // 괄호를 계산한다
-            res = level1();
+            QWidget::mouseReleaseEvent(e);
 
-            // 괄호 대응여부 확인
-            if (nextToken() != ")")
-                qDebug() << "')' 빠졌음";
+            return;
         }
-        else if (op == ")")
-            qDebug() << "')' 를 만났음";
-        else
-            res = level5();
 
-        return res;
+        _dragging = false;
+
+        unsetCursor();
     }
 
-    /**
-     * @brief 부호 또는 숫자를 계산한다
-     * @return 부호 또는 숫자의 값을 돌려준다
-     */
-    float level5()
-    {
-        float res;
-        QString op(peekToken());
+private:
+    typedef QPair<int, qint64> TileKey; ///< 확대 단계와 타일 번호
 
-        if (op == "+" || op == "-")
-            res = getSign() * level2();
-        else if (isNumber())
-            res = getNumber();
-        else
-            qDebug() << "알 수 없는 토큰을 만났음: " << op;
+    /// 캐시할 타일들의 최대 표본 수. 표본 하나는 x 값과 y 값으로 12 바이트
+    /// 남짓이므로 50 MB 정도
+    enum { MaxCachedSamples = 4 * 1024 * 1024 };
 
-        return res;
-    }
-};
+    QStringList _polys;         ///< 다항식들
+    AdaptiveSampler _sampler;   ///< 표본 추출기. 컴파일된 다항식들을 가짐
 
+    int _generation;        ///< 입력이 바뀔 때마다 늘어나는 세대
+    int _samplesGeneration; ///< 마지막으로 계산을 시작한 입력의 세대
 
-/**
- * @brief 그래프 위젯
- */
-class GraphWidget : public QWidget
-{
-public:
-    /**
-     * @brief GraphWidget 생성자
-     * @param parent 부모 위젯
-     */
-    GraphWidget(QWidget *parent = 0)
-            : QWidget(parent)
-            , _axisFixed(false)
-            , _start(0)
-            , _end(0)
-    {
-    }
+    QFutureWatcher<TiledSamples> _watcher;  ///< 표본 계산 감시자
+
+    QCache<TileKey, SampleTile> _tileCache; ///< 계산된 타일 캐시
+    int _cacheGeneration;       ///< 타일 캐시를 비울 때마다 늘어나는 세대
+    int _jobCacheGeneration;    ///< 계산 중인 작업을 시작할 때의 캐시 세대
+
+    GraphRenderer _renderer;    ///< 범위와 그리고 있는 표본을 가진 렌더러
+
+    DataSource *_source;        ///< 실시간 데이터 원본. 없으면 다항식을 그림
+    SeriesRenderer _series;     ///< 실시간 데이터의 점들과 픽스맵
+
+    bool _dragging;     ///< 화면을 끌고 있는지 여부
+    QPoint _dragPos;    ///< 끌기 시작한 위치
+    double _dragStart;  ///< 끌기 시작할 때의 시작값
+    double _dragEnd;    ///< 끌기 시작할 때의 끝값
+    double _dragScale;  ///< 끌기 시작할 때의 수평 배율
 
     /**
-     * @brief 좌표축 고정 상태 설정
-     * @param fixed true 이면 고정되고, false 이면 고정되지 않음
+     * @brief 타일 캐시를 비운다
+     * @remark 계산 중인 작업의 타일은 끝나도 캐시에 넣지 않는다
      */
-    void setAxisFixed(bool fixed)
+    void clearTileCache()
     {
-        _axisFixed = fixed;
+        _tileCache.clear();
+
+        _cacheGeneration++;
     }
 
     /**
-     * @brief 다항식을 설정한다
-     * @param poly 다항식
+     * @brief 타일을 캐시할 때의 비용을 구한다
+     * @param tile 계산된 타일
+     * @return 타일이 가진 표본, 근과 극값의 수
+     * @remark 더 나눈 표본의 수는 곡선의 모양에 따라 타일마다 크게 다르므로,
+     *         타일 수가 아니라 표본 수로 캐시의 크기를 제한한다
      */
-    void setPoly(const QString &poly)
+    static int tileCost(const SampleTile &tile)
     {
-        _poly = poly;
+        int cost = tile.xs.size();
+
+        for (int c = 0; c < tile.ys.size(); ++c)
+            cost += tile.ys.at(c).size();
+
+        for (int c = 0; c < tile.refinedXs.size(); ++c)
+            cost += tile.refinedXs.at(c).size();
+
+        for (int p = 0; p < tile.points.size(); ++p)
+            cost += tile.points.at(p).size();
+
+        return qMax(cost, 1);
     }
 
     /**
-     * @brief 범위를 설정한다
+     * @brief 사용자 조작으로 범위를 바꾼다
      * @param start 시작값
      * @param end 끝값
      */
-    void setRange(float start, float end)
+    void changeRange(double start, double end)
     {
-        _start = qMin(start, end);
-        _end = qMax(start, end);
+        setRange(start, end);
+
+        emit rangeChanged(_renderer.start(), _renderer.end());
+
+        update();
     }
 
-protected:
     /**
-     * @brief 위젯 내부를 그린다
+     * @brief 입력이 바뀌었으면 스레드 풀에서 표본 계산을 시작한다
+     * @remark 이미 계산 중이면, 끝난 뒤에 다시 확인한다. 캐시에 있는
+     *         타일은 다시 계산하지 않는다.
      */
-    void paintEvent(QPaintEvent */*e*/)
+    void startSampling()
     {
-        if (_poly.isEmpty())
+        if (_watcher.isRunning() || _samplesGeneration == _generation)
             return;
 
-        float xStart = _start;
-        float xEnd = _end;
-        float xDelta = (xEnd - xStart) / 1000; // 범위를 1,000 등분함
-
-        QList<QPointF> ptfs;
+        _samplesGeneration = _generation;
+        _jobCacheGeneration = _cacheGeneration;
 
-        PolyCalc pc(_poly);
+        double start = _renderer.start();
+        double end = _renderer.end();
 
-        // 최솟값과 최댓값 초기화
-        pc.setX(xStart);
-        float yMin = pc.calc();
-        float yMax = yMin;
+        qreal dpr = devicePixelRatioF();
+        int w = qMax(qRound(width() * dpr), 1);
 
-        // 점의 위치 계산
-        for (float x = xStart; x <= xEnd; x += xDelta)
-        {
-            QPointF ptf;
+        // 보이는 범위를 덮는 타일들. 없는 타일은 빈 타일로 넘김
+        int level = AdaptiveSampler::tileLevel((end - start) / w);
+        qint64 first, last;
 
-            ptf.setX(x);
+        AdaptiveSampler::tileRange(level, start, end, &first, &last);
 
-            pc.setX(x);
-            ptf.setY(pc.calc());
+        QVector<SampleTile> tiles;
 
-            ptfs.append(ptf);
-
-            // 최솟값 찾기
-            if (ptf.y() < yMin)
-                yMin = ptf.y();
-
-            // 최댓값 찾기
-            if (ptf.y() > yMax)
-                yMax = ptf.y();
-        }
-
-        // 상수 함수에 대한 보정
-        if (yMax == yMin)
+        for (qint64 index = first; index <= last; ++index)
         {
-            if (yMax == 0)
-            {
-                yMax = 10;
-                yMin = -10;
-            }
+            SampleTile *cached = _tileCache.object(qMakePair(level, index));
+
+            if (cached)
+                tiles.append(*cached);
             else
             {
-                yMax = qAbs(yMax);
-                yMin = -yMax;
+                SampleTile tile;
+
+                tile.level = level;
+                tile.index = index;
+                tile.tolerance = -1;
+
+                tiles.append(tile);
             }
         }
 
-        float xScale;   // 수평 배율
-        float yScale;   // 수직 배율
-
-        int xOrg;   // x 축 원점
-        int yOrg;   // y 축 원점
+        // 추출기의 복사본으로 계산하므로, 그동안 입력이 바뀌어도 안전함
+        _watcher.setFuture(QtConcurrent::run(_sampler,
+                                             &AdaptiveSampler::sampleTiles,
+                                             tiles, start, end,
+                                             qRound(height() * dpr)));
+    }
 
-        int w = width() - 1;    // 실제로 그릴 수 있는 폭
-        int h = height() - 1;   // 실제로 그릴 수 있는 높이
+private slots:
+    /**
+     * @brief 표본 계산이 끝났을 때 호출된다
+     */
+    void samplesReady()
+    {
+        TiledSamples result = _watcher.result();
 
-        if (_axisFixed)         // 좌표축이 고정되어 있으면,
+        // 그동안 다항식이나 허용 오차가 바뀌지 않았으면 타일 캐시
+        if (_jobCacheGeneration == _cacheGeneration)
         {
-            // 위젯의 중심을 기준으로 배율 계산
-            xScale = (w / 2) / qMax(qAbs(xStart), qAbs(xEnd));
-            yScale = (h / 2) / qMax(qAbs(yMin), qAbs(yMax));
-
-            // 위젯의 중심이 원점
-            xOrg = w / 2;
-            yOrg = h / 2;
+            foreach (const SampleTile &tile, result.tiles)
+                _tileCache.insert(qMakePair(tile.level, tile.index),
+                                  new SampleTile(tile), tileCost(tile));
         }
-        else                    // 좌표축이 고정되어 있지 않으면
-        {
-            // 수평 배율 계산
-            if (xEnd * xStart < 0 )
-                xScale = w * (xStart / (xEnd - xStart)) / xStart;
-            else
-                xScale = w / (xEnd - xStart);
 
-            // 수직 배율 계산
-            if (yMax * yMin < 0)
-                yScale = h * (yMin / (yMax - yMin)) / yMin;
-            else
-                yScale = h / (yMax - yMin);
+        // 표본이 바뀌었으므로 배율도 다시 계산
+        _renderer.setCurves(result.curves);
 
-            // 실제 그래프에 따라 원점 설정
-            xOrg = -xStart * xScale;
-            yOrg = yMax * yScale;
-        }
+        // 다시 그림. 그동안 입력이 바뀌었으면 새로 계산을 시작함
+        update();
+    }
 
-        QPainter painter(this);
+    /**
+     * @brief 데이터 원본에 점이 쌓였을 때 호출된다
+     * @remark 쌓인 점을 한꺼번에 가져가고, 다음 그리기에서 새 점만 그린다
+     */
+    void dataAvailable()
+    {
+        if (!_source)
+            return;
 
-        // 평행이동/원점 변경
-        painter.translate(xOrg, yOrg);
-        // 배율 설정, x 축 대칭.
-        painter.scale(1, -1);
+        QVector<double> xs;
+        QVector<float> ys;
 
-        // 좌표축의 색깔은 검은색
-        painter.setPen(Qt::black);
+        _source->take(&xs, &ys);
 
-        if (_axisFixed) // 좌표축이 고정되어 있으면
-        {
-            // 위젯 중심에 좌표축 그림
-            painter.drawLine(-xOrg, 0, xOrg, 0);
-            painter.drawLine(0, -yOrg, 0, yOrg);
-        }
-        else            // 좌표축이 고정되어 있지 않으면
-        {
-            // 실제 그래프에 따라 좌표축 그림
-            painter.drawLine(xStart * xScale, 0, xEnd * xScale, 0);
-            painter.drawLine(0, yMin * yScale, 0, yMax * yScale);
-        }
+        _series.append(xs.constData(), ys.constData(), xs.size());
 
-        // 그래프의 색깔은 빨간색
-        painter.setPen(Qt::red);
-
-        // 각 점들을 선으로 이음
-        for (int i = ptfs.count() - 1; i >= 1; --i)
-            painter.drawLine(ptfs.at(i).x() * xScale,
-                             ptfs.at(i).y() * yScale,
-                             ptfs.at(i-1).x() * xScale,
-                             ptfs.at(i-1).y() * yScale);
+        update();
     }
-
-private:
-    bool _axisFixed;    ///< 좌표축 고정 상태
-    QString _poly;      ///< 다항식
-    float _start;       ///< 시작값
-    float _end;         ///< 끝값
 };
 
 /**
@@ -564,6 +563,12 @@ void Plot::initMenus()
 {
     // '파일' 메뉴 생성
     QMenu *fileMenu = new QMenu(tr("파일(&F)"));
+    // '데이터 열기' 항목 추가
+    fileMenu->addAction(tr("데이터 열기(&O)..."), this, SLOT(openData()),
+                        QKeySequence(tr("Ctrl+O")));
+    // '표준 입력 읽기' 항목 추가
+    fileMenu->addAction(tr("표준 입력 읽기(&I)"), this, SLOT(readStdin()));
+    fileMenu->addSeparator();
     // '끝내기' 항목 추가
     fileMenu->addAction(tr("끝내기(&x)"), this, SLOT(close()),
                         QKeySequence(tr("Ctrl+Q")));
@@ -574,6 +579,45 @@ void Plot::initMenus()
     viewMenu->addAction(tr("좌표축 고정하기(&A)"), this, SLOT(axisFixed(bool)),
                         QKeySequence(tr("Ctrl+F")))->setCheckable(true);
 
+    // 체크 가능한 '도함수 그리기' 항목 추가
+    viewMenu->addAction(tr("도함수 그리기(&D)"), this,
+                        SLOT(derivativesVisible(bool)),
+                        QKeySequence(tr("Ctrl+D")))->setCheckable(true);
+    // 체크 가능한 '근과 극값 표시' 항목 추가
+    viewMenu->addAction(tr("근과 극값 표시(&R)"), this,
+                        SLOT(marksVisible(bool)),
+                        QKeySequence(tr("Ctrl+R")))->setCheckable(true);
+
+    // 하나만 고를 수 있는 '계산 정밀도' 하위 메뉴 추가
+    QMenu *precisionMenu = viewMenu->addMenu(tr("계산 정밀도(&P)"));
+    QActionGroup *precisionGroup = new QActionGroup(this);
+
+    static const struct
+    {
+        const char *text;
+        PolyCalc::Precision precision;
+    } precisions[] = {
+        {QT_TR_NOOP("자동(&A)"), PolyCalc::AutoPrecision},
+        {QT_TR_NOOP("float(&S)"), PolyCalc::SinglePrecision},
+        {QT_TR_NOOP("double(&D)"), PolyCalc::DoublePrecision},
+        {QT_TR_NOOP("long double(&L)"), PolyCalc::ExtendedPrecision}
+    };
+
+    for (size_t i = 0; i < sizeof(precisions) / sizeof(precisions[0]); ++i)
+    {
+        QAction *action = precisionMenu->addAction(tr(precisions[i].text));
+
+        action->setCheckable(true);
+        action->setChecked(precisions[i].precision
+                           == PolyCalc::AutoPrecision);
+        action->setData(precisions[i].precision);
+
+        precisionGroup->addAction(action);
+    }
+
+    connect(precisionGroup, SIGNAL(triggered(QAction*)),
+            this, SLOT(precisionChanged(QAction*)));
+
     // 메뉴바에 추가
     menuBar()->addMenu(fileMenu);
     menuBar()->addMenu(viewMenu);
@@ -585,6 +629,7 @@ void Plot::initMenus()
 void Plot::initWidgets()
 {
     _polyLine = new QLineEdit;
+    _polyLine->setPlaceholderText(tr("여러 다항식은 ';' 로 구분"));
     _startLine = new QLineEdit;
     _endLine = new QLineEdit;
 
@@ -599,6 +644,8 @@ void Plot::initWidgets()
     formLayout->addRow(_drawGraphPush);
 
     _graph = new GraphWidget;
+    connect(_graph, SIGNAL(rangeChanged(double,double)),
+            this, SLOT(graphRangeChanged(double,double)));
 
     QVBoxLayout *vboxLayout = new QVBoxLayout;
     vboxLayout->addLayout(formLayout);
@@ -613,6 +660,55 @@ void Plot::initWidgets()
     resize(640, 480);
 }
 
+/**
+ * @brief 실시간 데이터 원본을 열어 그린다
+ * @param name 파일 이름. '-' 이면 표준 입력
+ * @return 열었으면 true, 아니면 false
+ */
+bool Plot::openDataSource(const QString &name)
+{
+    DataSource *source = DataSource::create(name);
+
+    // 읽기 전에 연결해야 처음 읽은 점을 놓치지 않음
+    _graph->setDataSource(source);
+
+    QString error;
+
+    if (!source->start(&error))
+    {
+        _graph->setDataSource(0);
+
+        QMessageBox::warning(this, qApp->applicationDisplayName(),
+                             tr("데이터를 열 수 없습니다.\n%1").arg(error));
+
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief '데이터 열기' 항목이 선택될 때 호출된다
+ */
+void Plot::openData()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("데이터 열기"),
+            QString(),
+            tr("CSV 파일 (*.csv *.txt);;float 배열 (*.f32 *.bin);;"
+               "모든 파일 (*)"));
+
+    if (!fileName.isEmpty())
+        openDataSource(fileName);
+}
+
+/**
+ * @brief '표준 입력 읽기' 항목이 선택될 때 호출된다
+ */
+void Plot::readStdin()
+{
+    openDataSource("-");
+}
+
 /**
  * @brief '좌표축 고정하기' 항목이 선택될 때 호출된다
  * @param checked true 이면 체크 된 상태이고, false 이면 해제된 상태임
@@ -625,6 +721,56 @@ void Plot::axisFixed(bool checked)
     _graph->update();
 }
 
+/**
+ * @brief '도함수 그리기' 항목이 선택될 때 호출된다
+ * @param checked true 이면 체크 된 상태이고, false 이면 해제된 상태임
+ */
+void Plot::derivativesVisible(bool checked)
+{
+    // 그래프 위젯에 상태를 전달
+    _graph->setDerivativesVisible(checked);
+    // 그래프 다시 그림
+    _graph->update();
+}
+
+/**
+ * @brief '근과 극값 표시' 항목이 선택될 때 호출된다
+ * @param checked true 이면 체크 된 상태이고, false 이면 해제된 상태임
+ */
+void Plot::marksVisible(bool checked)
+{
+    // 그래프 위젯에 상태를 전달
+    _graph->setMarksVisible(checked);
+    // 그래프 다시 그림
+    _graph->update();
+}
+
+/**
+ * @brief '계산 정밀도' 항목이 선택될 때 호출된다
+ * @param action 선택된 항목. 데이터가 PolyCalc::Precision 값임
+ */
+void Plot::precisionChanged(QAction *action)
+{
+    // 그래프 위젯에 정밀도를 전달
+    _graph->setPrecision(
+                static_cast<PolyCalc::Precision>(action->data().toInt()));
+    // 그래프 다시 그림
+    _graph->update();
+}
+
+/**
+ * @brief 그래프 위젯에서 범위가 바뀌었을 때 호출된다
+ * @param start 시작값
+ * @param end 끝값
+ */
+void Plot::graphRangeChanged(double start, double end)
+{
+    // 편집기에 바뀐 범위를 보여 줌. 깊이 확대해도 구별되도록 double 의
+    // 유효 숫자만큼
+    _startLine->setText(QString::number(start, 'g', 15));
+    _endLine->setText(QString::number(end, 'g', 15));
+}
+
 /**
  * @brief 그래프를 그린다
  */
@@ -632,8 +778,17 @@ void Plot::drawGraph()
 {
     bool ok;
 
+    // ';' 로 나누어 여러 다항식을 함께 그림
+    QStringList polys;
+
+    foreach (const QString &poly, _polyLine->text().split(';'))
+    {
+        if (!poly.trimmed().isEmpty())
+            polys.append(poly.trimmed());
+    }
+
     // 다항식 입력 여부 확인
-    if (_polyLine->text().isEmpty())
+    if (polys.isEmpty())
     {
         QMessageBox::warning(this, qApp->applicationDisplayName(),
                              tr("다항식을 입력해 주세요"));
@@ -655,7 +810,7 @@ void Plot::drawGraph()
     }
 
     // 시작값 숫자 여부 확인
-    _startLine->text().toFloat(&ok);
+    _startLine->text().toDouble(&ok);
     if (!ok)
     {
         QMessageBox::warning(this, qApp->applicationDisplayName(),
@@ -678,7 +833,7 @@ void Plot::drawGraph()
     }
 
     // 끝값 숫자 여부 확인
-    _endLine->text().toFloat(&ok);
+    _endLine->text().toDouble(&ok);
     if (!ok)
     {
         QMessageBox::warning(this, qApp->applicationDisplayName(),
@@ -690,7 +845,7 @@ void Plot::drawGraph()
     }
 
     // 시작값과 끝값이 같은지 확인
-    if (_startLine->text().toFloat() == _endLine->text().toFloat())
+    if (_startLine->text().toDouble() == _endLine->text().toDouble())
     {
         QMessageBox::warning(this, qApp->applicationDisplayName(),
                              tr("시작값과 끝값에 다른 숫자를 입력해 주세요."));
@@ -700,9 +855,12 @@ void Plot::drawGraph()
         return;
     }
 
-    // 입력 결과를 그래프 위젯에 전달
-    _graph->setPoly(_polyLine->text());
-    _graph->setRange(_startLine->text().toFloat(), _endLine->text().toFloat());
+    // 입력 결과를 그래프 위젯에 전달. 실시간 데이터는 그만 그림
+    _graph->setDataSource(0);
+    _graph->setPolys(polys);
+    _graph->setRange(_startLine->text().toDouble(), _endLine->text().toDouble());
     // 그래프 다시 그림
     _graph->update();
 }
+
+#include "plot.moc"
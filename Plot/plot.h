@@ -40,6 +40,8 @@ public:
     Plot(QWidget *parent = 0);
     ~Plot();
 
+    bool openDataSource(const QString &name);
+
 private:
     QLineEdit *_polyLine;           ///< 다항식 편집기
     QLineEdit *_startLine;          ///< 시작값 편집기
@@ -51,8 +53,14 @@ private:
     void initWidgets();
 
 private slots:
+    void openData();
+    void readStdin();
     void axisFixed(bool checked);
+    void derivativesVisible(bool checked);
+    void marksVisible(bool checked);
     void drawGraph();
+    void precisionChanged(QAction *action);
+    void graphRangeChanged(double start, double end);
 };
 
 #endif // PLOT_H
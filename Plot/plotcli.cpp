@@ -0,0 +1,776 @@
+/****************************************************************************
+**
+** plotcli.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#include "plotcli.h"
+#include "datasource.h"
+#include "graphrenderer.h"
+#include "seriesrenderer.h"
+#include "vecmath.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPainter>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief 명령행 모드로 실행해야 하는지 알려준다
+ * @param argc 인수 개수
+ * @param argv 인수 배열
+ * @return 명령행 모드 옵션이 있으면 true, 아니면 false
+ * @remark QApplication 을 만들기 전에 부르므로 argv 를 직접 살펴본다
+ */
+bool PlotCli::isRequested(int argc, char *argv[])
+{
+    static const char *const options[] = {"--expr", "--batch", "--benchmark",
+                                           "--analyze", "--help", 0};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        for (int k = 0; options[k]; ++k)
+        {
+            // '--expr=x' 처럼 값을 붙여 쓴 경우도 찾음
+            int len = strlen(options[k]);
+
+            if (!strncmp(argv[i], options[k], len)
+                    && (argv[i][len] == '\0' || argv[i][len] == '='))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief 명령행 모드를 실행한다
+ * @param arguments 명령행 인수
+ * @return 모든 이미지를 저장했으면 0, 아니면 0 이 아닌 값
+ */
+int PlotCli::exec(const QStringList &arguments)
+{
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+            QObject::tr("창 없이 그래프를 이미지 파일로 그립니다."));
+    parser.addHelpOption();
+
+    QCommandLineOption exprOption("expr",
+            QObject::tr("그릴 다항식. 여러 개는 ';' 로 구분"),
+            QObject::tr("다항식"));
+    QCommandLineOption rangeOption("range",
+            QObject::tr("시작값과 끝값 (기본값: -10,10)"),
+            QObject::tr("시작값,끝값"), "-10,10");
+    QCommandLineOption sizeOption("size",
+            QObject::tr("이미지 크기 (기본값: 640x480)"),
+            QObject::tr("폭x높이"), "640x480");
+    QCommandLineOption outOption("out",
+            QObject::tr("저장할 이미지 파일"), QObject::tr("파일"));
+    QCommandLineOption axisFixedOption("axis-fixed",
+            QObject::tr("좌표축을 가운데에 고정"));
+    QCommandLineOption precisionOption("precision",
+            QObject::tr("계산 정밀도. auto, single, double, extended 중 "
+                        "하나 (기본값: auto)"),
+            QObject::tr("정밀도"), "auto");
+    QCommandLineOption derivativeOption("derivative",
+            QObject::tr("도함수 곡선을 점선으로 함께 그림"));
+    QCommandLineOption marksOption("marks",
+            QObject::tr("근과 극값을 표시"));
+    QCommandLineOption analyzeOption("analyze",
+            QObject::tr("그리지 않고 --range 안에서 --expr 의 근과 극값을 "
+                        "출력"));
+    QCommandLineOption batchOption("batch",
+            QObject::tr("작업 목록 파일. 한 줄에 "
+                        "'파일<TAB>다항식[<TAB>시작값,끝값[<TAB>폭x높이]]'"),
+            QObject::tr("파일"));
+    QCommandLineOption jobsOption("jobs",
+            QObject::tr("동시에 그릴 작업 수 (기본값: CPU 수)"),
+            QObject::tr("개수"));
+    QCommandLineOption benchmarkOption("benchmark",
+            QObject::tr("다항식 계산과 그리기 성능을 잼"));
+
+    parser.addOption(exprOption);
+    parser.addOption(rangeOption);
+    parser.addOption(sizeOption);
+    parser.addOption(outOption);
+    parser.addOption(axisFixedOption);
+    parser.addOption(precisionOption);
+    parser.addOption(derivativeOption);
+    parser.addOption(marksOption);
+    parser.addOption(analyzeOption);
+    parser.addOption(batchOption);
+    parser.addOption(jobsOption);
+    parser.addOption(benchmarkOption);
+
+    parser.process(arguments);
+
+    if (parser.isSet(benchmarkOption))
+        return benchmark();
+
+    // 배치 파일의 각 줄에서 빠진 값은 명령행 값을 씀
+    Job defaults;
+
+    defaults.axisFixed = parser.isSet(axisFixedOption);
+    defaults.derivatives = parser.isSet(derivativeOption);
+    defaults.marks = parser.isSet(marksOption);
+    defaults.ok = false;
+
+    if (!parseRange(parser.value(rangeOption),
+                    &defaults.start, &defaults.end))
+    {
+        err << QObject::tr("잘못된 범위: ") << parser.value(rangeOption)
+            << '\n';
+
+        return 2;
+    }
+
+    if (!parseSize(parser.value(sizeOption), &defaults.size))
+    {
+        err << QObject::tr("잘못된 크기: ") << parser.value(sizeOption)
+            << '\n';
+
+        return 2;
+    }
+
+    if (!parsePrecision(parser.value(precisionOption), &defaults.precision))
+    {
+        err << QObject::tr("잘못된 정밀도: ") << parser.value(precisionOption)
+            << '\n';
+
+        return 2;
+    }
+
+    if (parser.isSet(analyzeOption))
+    {
+        QStringList polys = splitPolys(parser.value(exprOption));
+
+        if (polys.isEmpty())
+        {
+            err << QObject::tr("--analyze 에는 --expr 을 지정해 주세요.")
+                << '\n';
+
+            return 2;
+        }
+
+        return analyze(polys, defaults.start, defaults.end);
+    }
+
+    QVector<Job> jobs;
+
+    if (parser.isSet(exprOption))
+    {
+        Job job = defaults;
+
+        job.polys = splitPolys(parser.value(exprOption));
+        job.out = parser.value(outOption);
+
+        if (job.polys.isEmpty() || job.out.isEmpty())
+        {
+            err << QObject::tr("--expr 와 --out 을 함께 지정해 주세요.")
+                << '\n';
+
+            return 2;
+        }
+
+        jobs.append(job);
+    }
+
+    if (parser.isSet(batchOption)
+            && !readBatch(parser.value(batchOption), defaults, &jobs))
+        return 2;
+
+    if (jobs.isEmpty())
+        parser.showHelp(2);
+
+    if (parser.isSet(jobsOption))
+    {
+        bool ok;
+        int count = parser.value(jobsOption).toInt(&ok);
+
+        if (!ok || count < 1)
+        {
+            err << QObject::tr("잘못된 작업 수: ") << parser.value(jobsOption)
+                << '\n';
+
+            return 2;
+        }
+
+        QThreadPool::globalInstance()->setMaxThreadCount(count);
+    }
+
+    // 작업마다 스레드 풀에서 동시에 그림
+    QtConcurrent::blockingMap(jobs, [](Job &job)
+    {
+        QImage image = GraphRenderer::render(job.polys, job.start, job.end,
+                                             job.size, job.axisFixed, 1,
+                                             job.precision, job.derivatives,
+                                             job.marks);
+
+        job.ok = image.save(job.out);
+    });
+
+    int failed = 0;
+
+    foreach (const Job &job, jobs)
+    {
+        if (!job.ok)
+        {
+            err << QObject::tr("저장하지 못함: ") << job.out << '\n';
+
+            failed++;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
+
+/**
+ * @brief 범위 안에서 다항식들의 근과 극값을 찾아 출력한다
+ * @param polys 다항식들
+ * @param start 시작값
+ * @param end 끝값
+ * @return 늘 0
+ * @remark 한 줄에 점 하나씩 '다항식<TAB>종류<TAB>x<TAB>y' 로 출력한다.
+ *         그래프를 그릴 때와 같이 추출기가 찾은 점이다.
+ */
+int PlotCli::analyze(const QStringList &polys, double start, double end)
+{
+    QTextStream out(stdout);
+
+    static const char *const kinds[] = {"root", "minimum", "maximum"};
+
+    if (start > end)
+        qSwap(start, end);
+
+    foreach (const QString &poly, polys)
+    {
+        AdaptiveSampler sampler(QVector<PolyCalc>() << PolyCalc(poly));
+
+        sampler.setMarks(true);
+
+        // 화면 크기는 격자 간격만 정하므로 넉넉히 잡음
+        CurveSamples curve = sampler.sample(start, end, 4096, 1024).first();
+
+        foreach (const CurvePoint &point, curve.points)
+        {
+            out << poly << '\t' << kinds[point.kind] << '\t'
+                << QString::number(point.x, 'g', 15) << '\t'
+                << QString::number(point.y, 'g', 7) << '\n';
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief ';' 로 구분된 다항식들을 나눈다
+ * @param text 다항식들
+ * @return 빈 항목을 뺀 다항식들
+ */
+QStringList PlotCli::splitPolys(const QString &text)
+{
+    QStringList polys;
+
+    foreach (const QString &poly, text.split(';'))
+    {
+        if (!poly.trimmed().isEmpty())
+            polys.append(poly.trimmed());
+    }
+
+    return polys;
+}
+
+/**
+ * @brief '시작값,끝값' 형식의 범위를 해석한다
+ * @param text 범위 문자열
+ * @param start 시작값을 돌려받음
+ * @param end 끝값을 돌려받음
+ * @return 올바른 범위이면 true, 아니면 false
+ */
+bool PlotCli::parseRange(const QString &text, double *start, double *end)
+{
+    QStringList values = text.split(',');
+
+    if (values.size() != 2)
+        return false;
+
+    bool ok1, ok2;
+
+    *start = values.at(0).trimmed().toDouble(&ok1);
+    *end = values.at(1).trimmed().toDouble(&ok2);
+
+    // 그래프 그리기 버튼과 마찬가지로 시작값과 끝값은 달라야 함
+    return ok1 && ok2 && *start != *end;
+}
+
+/**
+ * @brief '폭x높이' 형식의 크기를 해석한다
+ * @param text 크기 문자열
+ * @param size 크기를 돌려받음
+ * @return 올바른 크기이면 true, 아니면 false
+ */
+bool PlotCli::parseSize(const QString &text, QSize *size)
+{
+    QStringList values = text.toLower().split('x');
+
+    if (values.size() != 2)
+        return false;
+
+    bool ok1, ok2;
+
+    size->setWidth(values.at(0).trimmed().toInt(&ok1));
+    size->setHeight(values.at(1).trimmed().toInt(&ok2));
+
+    return ok1 && ok2 && size->width() > 1 && size->height() > 1;
+}
+
+/**
+ * @brief 정밀도 이름을 해석한다
+ * @param text auto, single, double, extended 중 하나
+ * @param precision 정밀도를 돌려받음
+ * @return 올바른 이름이면 true, 아니면 false
+ */
+bool PlotCli::parsePrecision(const QString &text,
+                             PolyCalc::Precision *precision)
+{
+    static const struct
+    {
+        const char *name;
+        PolyCalc::Precision precision;
+    } names[] = {
+        {"auto", PolyCalc::AutoPrecision},
+        {"single", PolyCalc::SinglePrecision},
+        {"double", PolyCalc::DoublePrecision},
+        {"extended", PolyCalc::ExtendedPrecision}
+    };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+    {
+        if (text.trimmed().toLower() == QLatin1String(names[i].name))
+        {
+            *precision = names[i].precision;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief 작업 목록 파일을 읽는다
+ * @param fileName 작업 목록 파일 이름
+ * @param defaults 빠진 값에 쓸 기본 작업
+ * @param jobs 읽은 작업들이 더해짐
+ * @return 모든 줄이 올바르면 true, 아니면 false
+ * @remark 한 줄에 작업 하나이며, 값들은 탭으로 구분한다. 빈 줄과 '#' 으로
+ *         시작하는 줄은 건너뛴다.
+ */
+bool PlotCli::readBatch(const QString &fileName, const Job &defaults,
+                        QVector<Job> *jobs)
+{
+    QTextStream err(stderr);
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        err << QObject::tr("열 수 없음: ") << fileName << '\n';
+
+        return false;
+    }
+
+    QTextStream in(&file);
+    int lineNo = 0;
+
+    while (!in.atEnd())
+    {
+        QString line = in.readLine();
+
+        lineNo++;
+
+        if (line.trimmed().isEmpty() || line.trimmed().startsWith('#'))
+            continue;
+
+        QStringList fields = line.split('\t');
+        Job job = defaults;
+
+        bool ok = fields.size() >= 2 && fields.size() <= 4;
+
+        if (ok)
+        {
+            job.out = fields.at(0).trimmed();
+            job.polys = splitPolys(fields.at(1));
+
+            ok = !job.out.isEmpty() && !job.polys.isEmpty();
+        }
+
+        if (ok && fields.size() >= 3)
+            ok = parseRange(fields.at(2), &job.start, &job.end);
+
+        if (ok && fields.size() >= 4)
+            ok = parseSize(fields.at(3), &job.size);
+
+        if (!ok)
+        {
+            err << fileName << ":" << lineNo << ": "
+                << QObject::tr("잘못된 작업") << '\n';
+
+            return false;
+        }
+
+        jobs->append(job);
+    }
+
+    return true;
+}
+
+/**
+ * @brief 함수를 충분히 여러 번 실행해 한 번에 걸리는 시간을 잰다
+ * @param func 잴 함수
+ * @return 한 번 실행에 걸린 초
+ * @remark 0.2 초가 지나고 적어도 3 번 실행할 때까지 되풀이한다
+ */
+template <typename Func>
+static double measure(Func func)
+{
+    QElapsedTimer timer;
+    int runs = 0;
+
+    timer.start();
+
+    do
+    {
+        func();
+        runs++;
+    } while (runs < 3 || timer.nsecsElapsed() < 200000000);
+
+    return timer.nsecsElapsed() / 1e9 / runs;
+}
+
+/**
+ * @brief 성능을 재고 결과를 표준 출력에 쓴다
+ * @return 항상 0
+ */
+int PlotCli::benchmark()
+{
+    benchmarkEval();
+    benchmarkRender();
+    benchmarkStream();
+
+    return 0;
+}
+
+/**
+ * @brief 복잡도가 다른 다항식들의 초당 계산 횟수를 잰다
+ * @remark calc() 로 하나씩 계산할 때와 evalBatch() 로 한꺼번에 계산할 때,
+ *         기계어로 번역해 계산할 때, double 로 한꺼번에 계산할 때를
+ *         비교한다
+ */
+void PlotCli::benchmarkEval()
+{
+    QTextStream out(stdout);
+
+    // 깊이가 늘어나는 다항식. 깊이 d 는 ((x*x+1)*x+2)*x+... 꼴
+    QStringList polys;
+    QString nested = "x";
+
+    for (int depth = 1; depth <= 32; depth *= 2)
+    {
+        while (nested.count('x') < depth)
+            nested = QString("(%1)*x+%2").arg(nested).arg(nested.count('x'));
+
+        polys.append(nested);
+    }
+
+    polys << "1/x" << "x^10-3*x^5+2" << "(x^3-2*x)/(x^2+1)";
+
+    const int count = 1 << 16;
+
+    QVector<float> xs(count);
+    QVector<float> ys(count);
+    QVector<double> wideXs(count);
+    QVector<double> wideYs(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        xs[i] = -2 + 4.0f * i / count;
+        wideXs[i] = xs.at(i);
+    }
+
+    out << QObject::tr("다항식 계산 (%1, %2 개 x 값)")
+               .arg(VecMath::instructionSet()).arg(count) << '\n';
+    out << QString("%1 %2 %3 %4 %5 %6")
+               .arg(QObject::tr("명령어"), 8)
+               .arg("calc() M/s", 12)
+               .arg("evalBatch() M/s", 16)
+               .arg("JIT M/s", 10)
+               .arg("double M/s", 12)
+               .arg(QObject::tr("다항식"))
+        << '\n';
+
+    bool jitEnabled = PolyCalc::jitEnabled();
+
+    foreach (const QString &poly, polys)
+    {
+        // 스택 기계와 번역된 기계어를 따로 잼
+        PolyCalc::setJitEnabled(false);
+
+        PolyCalc polyCalc(poly);
+
+        PolyCalc::setJitEnabled(true);
+
+        PolyCalc jitCalc(poly);
+
+        // 결과를 써서 계산이 최적화로 사라지지 않게 함
+        volatile float sink = 0;
+
+        double scalar = measure([&]
+        {
+            float sum = 0;
+
+            for (int i = 0; i < count; ++i)
+                sum += polyCalc.calc(xs.at(i));
+
+            sink = sum;
+        });
+
+        double batch = measure([&]
+        {
+            polyCalc.evalBatch(xs.constData(), ys.data(), count);
+
+            sink = ys.at(count / 2);
+        });
+
+        // 번역할 수 없는 다항식은 '-' 로 표시
+        QString jit("-");
+
+        if (jitCalc.isJitCompiled())
+        {
+            double jitTime = measure([&]
+            {
+                jitCalc.evalBatch(xs.constData(), ys.data(), count);
+
+                sink = ys.at(count / 2);
+            });
+
+            jit = QString::number(count / jitTime / 1e6, 'f', 1);
+        }
+
+        double wide = measure([&]
+        {
+            polyCalc.evalBatch(wideXs.constData(), wideYs.data(), count);
+
+            sink = wideYs.at(count / 2);
+        });
+
+        Q_UNUSED(sink);
+
+        out << QString("%1 %2 %3 %4 %5 %6")
+                   .arg(polyCalc.code().size(), 8)
+                   .arg(count / scalar / 1e6, 12, 'f', 1)
+                   .arg(count / batch / 1e6, 16, 'f', 1)
+                   .arg(jit, 10)
+                   .arg(count / wide / 1e6, 12, 'f', 1)
+                   .arg(poly)
+            << '\n';
+
+        // 다항식마다 오래 걸리므로 잰 줄을 바로 내보냄
+        out.flush();
+    }
+
+    PolyCalc::setJitEnabled(jitEnabled);
+
+    out << '\n';
+}
+
+/**
+ * @brief 크기와 곡선 수에 따른 표본 계산 시간과 그리기 시간을 잰다
+ * @remark 그리기 시간에는 배율 계산과 점 줄이기가 포함된다
+ */
+void PlotCli::benchmarkRender()
+{
+    QTextStream out(stdout);
+
+    static const QSize sizes[] = {
+        QSize(320, 240), QSize(640, 480), QSize(1280, 960), QSize(2560, 1440)
+    };
+
+    // 곡선 1 개, 불연속점이 있는 곡선, 곡선 16 개
+    QList<QStringList> polySets;
+
+    polySets << (QStringList() << "x^3-2*x")
+             << (QStringList() << "1/(x^2-1)");
+
+    QStringList family;
+
+    for (int k = 1; k <= 16; ++k)
+        family << QString("x^%1/%2").arg(k).arg(k);
+
+    polySets << family;
+
+    out << QObject::tr("그리기 (범위 -2,2)") << '\n';
+    out << QString("%1 %2 %3 %4 %5")
+               .arg(QObject::tr("크기"), 10)
+               .arg(QObject::tr("곡선"), 5)
+               .arg(QObject::tr("표본"), 9)
+               .arg(QObject::tr("표본 ms"), 9)
+               .arg(QObject::tr("그리기 ms"), 9)
+        << '\n';
+
+    for (const QSize &size : sizes)
+    {
+        foreach (const QStringList &polys, polySets)
+        {
+            QVector<PolyCalc> polyCalcs;
+
+            foreach (const QString &poly, polys)
+                polyCalcs.append(PolyCalc(poly));
+
+            AdaptiveSampler sampler(polyCalcs);
+            QVector<CurveSamples> curves;
+
+            double sampleTime = measure([&]
+            {
+                curves = sampler.sample(-2, 2, size.width(), size.height());
+            });
+
+            int samples = 0;
+
+            foreach (const CurveSamples &curve, curves)
+                samples += curve.xs.size();
+
+            GraphRenderer renderer;
+
+            renderer.setRange(-2, 2);
+            renderer.setSize(size);
+
+            QImage image(size, QImage::Format_ARGB32_Premultiplied);
+
+            double paintTime = measure([&]
+            {
+                // 표본을 다시 설정해 배율과 점 줄이기도 매번 계산
+                renderer.setCurves(curves);
+
+                image.fill(Qt::white);
+
+                QPainter painter(&image);
+
+                renderer.paint(&painter);
+            });
+
+            out << QString("%1 %2 %3 %4 %5")
+                       .arg(QString("%1x%2").arg(size.width())
+                                            .arg(size.height()), 10)
+                       .arg(polys.size(), 5)
+                       .arg(samples, 9)
+                       .arg(sampleTime * 1e3, 9, 'f', 2)
+                       .arg(paintTime * 1e3, 9, 'f', 2)
+                << '\n';
+
+            out.flush();
+        }
+    }
+}
+
+/**
+ * @brief 실시간 데이터의 해석 속도와 이어 그리기 속도를 잰다
+ * @remark 이어 그리기는 한 번에 BatchSize 개씩 더하고 그릴 때마다 잰다.
+ *         점 수가 고리 버퍼보다 많으므로 픽스맵을 미는 경우도 포함된다.
+ */
+void PlotCli::benchmarkStream()
+{
+    QTextStream out(stdout);
+
+    const int count = 1 << 21;
+    const int batchSize = 4096;     // 초당 10 만 점을 40 ms 마다 그릴 때
+
+    QVector<double> xs(count);
+    QVector<float> ys(count);
+    QByteArray csv;
+
+    for (int i = 0; i < count; ++i)
+    {
+        xs[i] = i;
+        ys[i] = std::sin(i * 1e-3) + (i % 7) * 1e-2f;
+
+        csv += QByteArray::number(xs.at(i)) + ','
+               + QByteArray::number(ys.at(i)) + '\n';
+    }
+
+    out << QObject::tr("실시간 데이터 (%1 개 점, %2 개씩)")
+               .arg(count).arg(batchSize) << '\n';
+
+    QVector<double> parsedXs;
+    QVector<float> parsedYs;
+
+    double parseTime = measure([&]
+    {
+        qint64 index = 0;
+
+        parsedXs.clear();
+        parsedYs.clear();
+
+        DataSource::parseCsv(csv.constData(), csv.size(), &index,
+                             &parsedXs, &parsedYs);
+    });
+
+    out << QString("%1 %2 M/s")
+               .arg(QObject::tr("CSV 해석"), -12)
+               .arg(count / parseTime / 1e6, 8, 'f', 2)
+        << '\n';
+
+    QSize size(1280, 960);
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    int redraws = 0;
+
+    double drawTime = measure([&]
+    {
+        SeriesRenderer renderer;
+
+        renderer.setSize(size);
+
+        for (int i = 0; i < count; i += batchSize)
+        {
+            int n = qMin(batchSize, count - i);
+
+            renderer.append(xs.constData() + i, ys.constData() + i, n);
+
+            QPainter painter(&image);
+
+            renderer.paint(&painter);
+        }
+
+        redraws = renderer.redrawCount();
+    });
+
+    out << QString("%1 %2 M/s, %3")
+               .arg(QObject::tr("이어 그리기"), -12)
+               .arg(count / drawTime / 1e6, 8, 'f', 2)
+               .arg(QObject::tr("다시 그리기 %1 번").arg(redraws))
+        << '\n';
+}
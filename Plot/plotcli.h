@@ -0,0 +1,92 @@
+/****************************************************************************
+**
+** plotcli.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef PLOTCLI_H
+#define PLOTCLI_H
+
+#include "polycalc.h"
+
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief 명령행 모드
+ *
+ * 창 없이 그래프를 이미지 파일로 그린다. 배치 파일의 작업들은 스레드
+ * 풀에서 동시에 그린다. --benchmark 를 주면 다항식 계산과 그리기,
+ * 실시간 데이터 처리 성능을 잰다. --analyze 를 주면 그리지 않고 범위 안의
+ * 근과 극값을 출력한다.
+ *
+ * @code
+ * plot --expr "x^2;x^3" --range -2,2 --size 800x600 --out graph.png
+ * plot --expr "(x-1000)^5" --range 999,1001 --precision double --out deep.png
+ * plot --expr "x^3-2*x" --range -2,2 --derivative --marks --out diff.png
+ * plot --expr "x^3-2*x" --range -2,2 --analyze
+ * plot --batch jobs.txt --jobs 8
+ * plot --benchmark
+ * @endcode
+ */
+class PlotCli
+{
+public:
+    static bool isRequested(int argc, char *argv[]);
+
+    int exec(const QStringList &arguments);
+
+private:
+    /**
+     * @brief 이미지 하나를 그리는 작업
+     */
+    struct Job
+    {
+        QStringList polys;  ///< 함께 그릴 다항식들
+        double start;       ///< 시작값
+        double end;         ///< 끝값
+        QSize size;         ///< 이미지 크기
+        bool axisFixed;     ///< 좌표축 고정 여부
+        PolyCalc::Precision precision;  ///< 계산 정밀도
+        bool derivatives;   ///< 도함수 곡선을 함께 그릴지 여부
+        bool marks;         ///< 근과 극값을 표시할지 여부
+        QString out;        ///< 저장할 파일 이름
+        bool ok;            ///< 저장에 성공했는지 여부
+    };
+
+    static QStringList splitPolys(const QString &text);
+    static bool parseRange(const QString &text, double *start, double *end);
+    static bool parseSize(const QString &text, QSize *size);
+    static bool parsePrecision(const QString &text,
+                               PolyCalc::Precision *precision);
+
+    static bool readBatch(const QString &fileName, const Job &defaults,
+                          QVector<Job> *jobs);
+
+    static int analyze(const QStringList &polys, double start, double end);
+
+    static int benchmark();
+    static void benchmarkEval();
+    static void benchmarkRender();
+    static void benchmarkStream();
+};
+
+#endif // PLOTCLI_H
@@ -0,0 +1,1064 @@
+/****************************************************************************
+**
+** polycalc.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#include "polycalc.h"
+#include "dual.h"
+#include "polyjit.h"
+#include "polyoptimizer.h"
+#include "vecmath.h"
+
+#include <QDebug>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief 다항식 컴파일러
+ *
+ * 다항식을 토큰으로 나눈 뒤, 우선 순위별 재귀 하강 파싱을 하면서
+ * 후위 표기법 순서로 명령어를 만든다.
+ */
+class PolyCompiler
+{
+public:
+    /**
+     * @brief PolyCompiler 생성자
+     * @param poly 다항식
+     * @param code 만들어진 명령어를 저장할 배열
+     */
+    PolyCompiler(const QString &poly, QVector<PolyCalc::Instruction> *code)
+        : _pos(0)
+        , _code(code)
+    {
+        tokenize(poly);
+    }
+
+    /**
+     * @brief 다항식을 컴파일한다
+     */
+    void compile()
+    {
+        _pos = 0;
+
+        level1();
+    }
+
+private:
+    /**
+     * @brief 토큰
+     */
+    struct Token
+    {
+        enum Type {End, Number, X, Symbol};
+
+        Type type;      ///< 토큰 종류
+        QString text;   ///< 토큰 문자열
+        double number;  ///< Number 토큰의 값
+    };
+
+    QVector<Token> _tokens;                 ///< 토큰 목록. End 토큰으로 끝남
+    int _pos;                               ///< 현재 파싱 위치
+    QVector<PolyCalc::Instruction> *_code;  ///< 명령어 배열
+
+    /**
+     * @brief 다항식을 토큰으로 나눈다
+     * @param poly 다항식
+     */
+    void tokenize(const QString &poly)
+    {
+        int pos = 0;
+
+        forever
+        {
+            // 공백 문자 무시
+            while (pos < poly.length() && poly.at(pos).isSpace())
+                pos++;
+
+            Token tok;
+
+            if (pos >= poly.length())
+            {
+                tok.type = Token::End;
+                _tokens.append(tok);
+
+                break;
+            }
+
+            int start = pos;
+            QChar ch = poly.at(pos++);
+
+            if (ch.isNumber())
+            {
+                // 숫자 파싱
+                while (pos < poly.length() && poly.at(pos).isNumber())
+                    pos++;
+            }
+            else if (ch.isLetter())
+            {
+                // 문자 파싱
+                while (pos < poly.length() && poly.at(pos).isLetter())
+                    pos++;
+            }
+            // 나머지는 한 문자가 하나의 토큰
+
+            tok.text = poly.mid(start, pos - start);
+
+            if (tok.text == "x")
+                tok.type = Token::X;
+            else
+            {
+                bool ok;
+
+                tok.number = tok.text.toDouble(&ok);
+                tok.type = ok ? Token::Number : Token::Symbol;
+            }
+
+            _tokens.append(tok);
+        }
+    }
+
+    /**
+     * @brief 토큰을 읽지만, 파싱 위치 바꾸지 않는다
+     * @return 현재 토큰
+     */
+    inline const Token &peekToken() const
+    {
+        return _tokens.at(_pos);
+    }
+
+    /**
+     * @brief 토큰을 읽고, 파싱 위치를 바꾼다
+     * @return 현재 토큰
+     */
+    inline const Token &nextToken()
+    {
+        const Token &tok = _tokens.at(_pos);
+
+        if (tok.type != Token::End)
+            _pos++;
+
+        return tok;
+    }
+
+    /**
+     * @brief 토큰이 주어진 기호인지 알려준다
+     * @param tok 토큰
+     * @param symbols 기호 목록
+     * @return 토큰이 기호 목록 중 하나이면 true, 아니면 false
+     */
+    static inline bool isSymbol(const Token &tok, const char *symbols)
+    {
+        if (tok.type != Token::Symbol || tok.text.length() != 1)
+            return false;
+
+        char ch = tok.text.at(0).toLatin1();
+
+        return ch && strchr(symbols, ch);
+    }
+
+    /**
+     * @brief 명령어를 추가한다
+     * @param op 명령어 종류
+     * @param value PushConst 의 상수값
+     */
+    inline void addInstruction(PolyCalc::OpCode op, double value = 0)
+    {
+        PolyCalc::Instruction ins;
+
+        ins.op = op;
+        ins.value = value;
+
+        _code->append(ins);
+    }
+
+    /**
+     * @brief 더하기/빼기를 컴파일한다
+     */
+    void level1()
+    {
+        if (isSymbol(peekToken(), "+-"))
+            addInstruction(PolyCalc::PushConst, 0); // 0 에서 시작
+        else if (peekToken().type == Token::End)
+        {
+            addInstruction(PolyCalc::PushConst, 0); // 빈 다항식은 0
+
+            return;
+        }
+        else
+            level2();   // 더 높은 우선순위로 넘김
+
+        // 더하기/빼기가 이어지면 계속 컴파일
+        while (isSymbol(peekToken(), "+-"))
+        {
+            bool add = nextToken().text == "+";
+
+            // 오른쪽 값 컴파일
+            level2();
+
+            addInstruction(add ? PolyCalc::Add : PolyCalc::Sub);
+        }
+    }
+
+    /**
+     * @brief 곱하기/나누기를 컴파일한다
+     */
+    void level2()
+    {
+        // 왼쪽 값이 없으면 0 으로 간주
+        if (isSymbol(peekToken(), "*/") || peekToken().type == Token::End)
+            addInstruction(PolyCalc::PushConst, 0);
+        else
+            level3();   // 더 높은 우선 순위로 넘김
+
+        // 곱하기/나누기가 이어지면 계속 컴파일
+        while (isSymbol(peekToken(), "*/"))
+        {
+            bool mul = nextToken().text == "*";
+
+            // 오른쪽 값 컴파일
+            level3();
+
+            addInstruction(mul ? PolyCalc::Mul : PolyCalc::Div);
+        }
+    }
+
+    /**
+     * @brief 거듭제곱을 컴파일한다
+     */
+    void level3()
+    {
+        // 왼쪽 값이 없으면 0 으로 간주
+        if (isSymbol(peekToken(), "^") || peekToken().type == Token::End)
+            addInstruction(PolyCalc::PushConst, 0);
+        else
+            level4();   // 더 높은 우선 순위로 넘김
+
+        // 거듭제곱이 이어지면 계속 컴파일
+        while (isSymbol(peekToken(), "^"))
+        {
+            nextToken();
+
+            // 오른쪽 값 컴파일
+            level4();
+
+            addInstruction(PolyCalc::Pow);
+        }
+    }
+
+    /**
+     * @brief 괄호를 컴파일한다
+     */
+    void level4()
+    {
+        if (isSymbol(peekToken(), "("))
+        {
+            nextToken();
+
+            // 괄호 안을 컴파일한다
+            level1();
+
+            // 괄호 대응여부 확인
+            if (!isSymbol(nextToken(), ")"))
+                qDebug() << "')' 빠졌음";
+        }
+        else if (isSymbol(peekToken(), ")"))
+        {
+            qDebug() << "')' 를 만났음";
+
+            addInstruction(PolyCalc::PushConst, 0);
+        }
+        else
+            level5();
+    }
+
+    /**
+     * @brief 부호 또는 숫자를 컴파일한다
+     */
+    void level5()
+    {
+        const Token &tok = peekToken();
+
+        if (isSymbol(tok, "+-"))
+        {
+            bool negative = false;
+
+            // 연속된 부호 허용
+            while (isSymbol(peekToken(), "+-"))
+            {
+                if (nextToken().text == "-")
+                    negative = !negative;
+            }
+
+            level2();
+
+            if (negative)
+                addInstruction(PolyCalc::Neg);
+        }
+        else if (tok.type == Token::Number)
+        {
+            addInstruction(PolyCalc::PushConst, tok.number);
+
+            nextToken();
+        }
+        else if (tok.type == Token::X)
+        {
+            addInstruction(PolyCalc::PushX);
+
+            nextToken();
+        }
+        else
+        {
+            qDebug() << "알 수 없는 토큰을 만났음: " << tok.text;
+
+            addInstruction(PolyCalc::PushConst, 0);
+        }
+    }
+};
+
+/**
+ * @brief 정수 거듭제곱을 계산한다
+ * @param base 밑
+ * @param exponent 정수 지수
+ * @return base^exponent
+ * @remark VecMath::powInt() 와 같은 순서로 곱한다
+ */
+template <typename T>
+inline T powInt(T base, int exponent)
+{
+    T r = T(1);
+
+    for (unsigned k = exponent < 0 ? 0u - exponent : exponent; k; k >>= 1)
+    {
+        if (k & 1)
+            r *= base;
+
+        if (k > 1)
+            base *= base;
+    }
+
+    return exponent < 0 ? T(1) / r : r;
+}
+
+/**
+ * @brief double x 값을 T 로 바꾸어 계산하고, 결과를 float 로 돌려준다
+ * @param polyCalc 계산할 다항식
+ * @param xs x 값 배열
+ * @param ys 계산 결과를 저장할 배열
+ * @param n 개수
+ */
+template <typename T>
+void evalAs(const PolyCalc &polyCalc, const double *xs, float *ys, size_t n)
+{
+    enum { ChunkSize = 256 };
+
+    T in[ChunkSize];
+    T out[ChunkSize];
+
+    for (size_t base = 0; base < n; base += ChunkSize)
+    {
+        size_t len = qMin<size_t>(ChunkSize, n - base);
+
+        std::copy(xs + base, xs + base + len, in);
+
+        polyCalc.evalBatch(in, out, len);
+
+        std::copy(out, out + len, ys + base);
+    }
+}
+
+/**
+ * @brief 부호가 바뀌는 구간에서 함수의 근을 찾는다
+ * @param func 함수. func(x, &dg) 는 g(x) 를 돌려주고 dg 에 g'(x) 를 줌
+ * @param a 구간 시작
+ * @param b 구간 끝
+ * @param x 찾은 근을 돌려받음
+ * @return 찾았으면 true, 아니면 false
+ * @remark 뉴턴 방법으로 찾되, 다음 점이 구간을 벗어나면 이분법을 쓴다.
+ *         부호는 바뀌지만 |g| 가 양 끝보다 커지면 근이 아니라 극으로 본다.
+ */
+template <typename Func>
+bool solveBracketed(Func func, double a, double b, double *x)
+{
+    enum { MaxIterations = 64 };
+
+    const double eps = std::numeric_limits<double>::epsilon();
+
+    double d;
+    double ga = func(a, &d);
+    double gb = func(b, &d);
+
+    if (ga == 0 || gb == 0)
+    {
+        *x = ga == 0 ? a : b;
+
+        return true;
+    }
+
+    if (!((ga < 0) != (gb < 0)))
+        return false;
+
+    double limit = qMin(qAbs(ga), qAbs(gb));
+    double t = (a + b) / 2;
+
+    for (int i = 0; i < MaxIterations; ++i)
+    {
+        double g = func(t, &d);
+
+        if (g == 0 || !qIsFinite(g))
+            break;
+
+        // 부호에 따라 구간을 좁힘
+        if ((g < 0) == (ga < 0))
+            a = t;
+        else
+            b = t;
+
+        double next = t - g / d;
+
+        if (!(next > a && next < b))
+            next = (a + b) / 2;
+
+        bool converged = qAbs(next - t) <= 2 * eps * qAbs(next)
+                         || b - a <= 4 * eps * qMax(qAbs(a), qAbs(b));
+
+        t = next;
+
+        if (converged)
+            break;
+    }
+
+    if (!(qAbs(func(t, &d)) <= limit))
+        return false;
+
+    *x = t;
+
+    return true;
+}
+
+} // namespace
+
+bool PolyCalc::_jitEnabled = true;
+
+/**
+ * @brief PolyCalc 생성자
+ * @param poly 다항식
+ */
+PolyCalc::PolyCalc(const QString &poly)
+    : _stackSize(0)
+    , _x(0)
+{
+    setPoly(poly);
+}
+
+/**
+ * @brief 다항식을 설정하고 명령어 배열로 컴파일한다
+ * @param poly 다항식
+ */
+void PolyCalc::setPoly(const QString &poly)
+{
+    _poly = poly;
+    _code.clear();
+
+    PolyCompiler(poly, &_code).compile();
+
+    // 상수 계산, 정수 거듭제곱, Horner 꼴 등으로 명령어 수를 줄임
+    _code = PolyOptimizer(_code).optimize();
+
+    // 필요한 스택 크기 계산
+    int depth = 0;
+
+    _stackSize = 0;
+
+    foreach (const Instruction &ins, _code)
+    {
+        switch (ins.op)
+        {
+        case PushConst:
+        case PushX:
+            depth++;
+            break;
+
+        case Neg:
+        case PowInt:
+            break;
+
+        default:    // 이항 연산자
+            depth--;
+            break;
+        }
+
+        _stackSize = qMax(_stackSize, depth);
+    }
+
+    // 번역할 수 없으면 0 이 되어 스택 기계로 계산함
+    _jit = QSharedPointer<PolyJit>(_jitEnabled
+                                   ? PolyJit::compile(_code, _stackSize) : 0);
+}
+
+/**
+ * @brief 주어진 x 값으로 다항식을 계산한다
+ * @param x x 값
+ * @return 계산 결과를 돌려준다
+ * @remark 스택과 상수, 모든 중간 결과가 T 형이다. T 가 Dual 이면 pow() 는
+ *         Dual 의 것을 쓴다.
+ */
+template <typename T>
+T PolyCalc::run(T x) const
+{
+    using std::pow;
+
+    QVarLengthArray<T, 64> stack(_stackSize);
+    T *sp = stack.data();       // 다음에 넣을 위치
+
+    const Instruction *ins = _code.constData();
+    const Instruction *end = ins + _code.size();
+
+    for (; ins != end; ++ins)
+    {
+        switch (ins->op)
+        {
+        case PushConst:
+            *sp++ = static_cast<T>(ins->value);
+            break;
+
+        case PushX:
+            *sp++ = x;
+            break;
+
+        case Add:
+            --sp;
+            sp[-1] += *sp;
+            break;
+
+        case Sub:
+            --sp;
+            sp[-1] -= *sp;
+            break;
+
+        case Mul:
+            --sp;
+            sp[-1] *= *sp;
+            break;
+
+        case Div:
+            --sp;
+            sp[-1] /= *sp;
+            break;
+
+        case Pow:
+            --sp;
+            sp[-1] = pow(sp[-1], *sp);
+            break;
+
+        case Neg:
+            sp[-1] = -sp[-1];
+            break;
+
+        case PowInt:
+            sp[-1] = powInt(sp[-1], static_cast<int>(ins->value));
+            break;
+        }
+    }
+
+    return stack[0];
+}
+
+/**
+ * @brief 주어진 x 값으로 다항식을 float 로 계산한다
+ * @param x x 값
+ * @return 계산 결과를 돌려준다
+ */
+float PolyCalc::calc(float x) const
+{
+    return run(x);
+}
+
+/**
+ * @brief 주어진 x 값으로 다항식을 double 로 계산한다
+ * @param x x 값
+ * @return 계산 결과를 돌려준다
+ */
+double PolyCalc::calc(double x) const
+{
+    return run(x);
+}
+
+/**
+ * @brief 주어진 x 값으로 다항식을 long double 로 계산한다
+ * @param x x 값
+ * @return 계산 결과를 돌려준다
+ */
+long double PolyCalc::calc(long double x) const
+{
+    return run(x);
+}
+
+/**
+ * @brief 여러 x 값에 대해 다항식을 한꺼번에 계산한다
+ * @param xs x 값 배열
+ * @param ys 계산 결과를 저장할 배열
+ * @param n 개수
+ * @remark float 의 evalBatch() 와 같이 BlockSize 개씩 묶어서 계산하지만,
+ *         SIMD 함수 대신 일반 반복문을 쓴다
+ */
+template <typename T>
+void PolyCalc::runBatch(const T *xs, T *ys, size_t n) const
+{
+    using std::pow;
+
+    enum { BlockSize = 256 };
+
+    QVarLengthArray<T, 8 * BlockSize> stack(_stackSize * BlockSize);
+
+    const Instruction *begin = _code.constData();
+    const Instruction *end = begin + _code.size();
+
+    for (size_t base = 0; base < n; base += BlockSize)
+    {
+        int len = static_cast<int>(qMin<size_t>(BlockSize, n - base));
+        T *sp = stack.data();   // 다음에 넣을 위치
+
+        for (const Instruction *ins = begin; ins != end; ++ins)
+        {
+            switch (ins->op)
+            {
+            case PushConst:
+                std::fill(sp, sp + len, static_cast<T>(ins->value));
+                sp += BlockSize;
+                break;
+
+            case PushX:
+                std::copy(xs + base, xs + base + len, sp);
+                sp += BlockSize;
+                break;
+
+            case Add:
+                sp -= BlockSize;
+                for (int i = 0; i < len; ++i)
+                    sp[i - BlockSize] += sp[i];
+                break;
+
+            case Sub:
+                sp -= BlockSize;
+                for (int i = 0; i < len; ++i)
+                    sp[i - BlockSize] -= sp[i];
+                break;
+
+            case Mul:
+                sp -= BlockSize;
+                for (int i = 0; i < len; ++i)
+                    sp[i - BlockSize] *= sp[i];
+                break;
+
+            case Div:
+                sp -= BlockSize;
+                for (int i = 0; i < len; ++i)
+                    sp[i - BlockSize] /= sp[i];
+                break;
+
+            case Pow:
+                sp -= BlockSize;
+                for (int i = 0; i < len; ++i)
+                    sp[i - BlockSize] = pow(sp[i - BlockSize], sp[i]);
+                break;
+
+            // 단항 연산자는 맨 위 칸을 그 자리에서 바꿈
+            case Neg:
+                for (int i = 0; i < len; ++i)
+                    sp[i - BlockSize] = -sp[i - BlockSize];
+                break;
+
+            case PowInt:
+                for (int i = 0; i < len; ++i)
+                    sp[i - BlockSize] = powInt(sp[i - BlockSize],
+                                               static_cast<int>(ins->value));
+                break;
+            }
+        }
+
+        std::copy(stack.data(), stack.data() + len, ys + base);
+    }
+}
+
+/**
+ * @brief 여러 x 값에 대해 다항식을 한꺼번에 계산한다
+ * @param xs x 값 배열
+ * @param ys 계산 결과를 저장할 배열
+ * @param n 개수
+ * @remark 기계어로 번역되었으면 번역된 기계어로 계산한다. 아니면 x 값을
+ *         BlockSize 개씩 묶어서, 명령어 하나를 묶음 전체에 대해 실행한다.
+ *         스택의 각 칸은 값 하나가 아니라 BlockSize 개의 배열이다.
+ */
+void PolyCalc::evalBatch(const float *xs, float *ys, size_t n) const
+{
+    if (_jit)
+    {
+        _jit->evalBatch(xs, ys, n);
+
+        return;
+    }
+
+    enum { BlockSize = 256 };
+
+    QVarLengthArray<float, 8 * BlockSize> stack(_stackSize * BlockSize);
+
+    const Instruction *begin = _code.constData();
+    const Instruction *end = begin + _code.size();
+
+    for (size_t base = 0; base < n; base += BlockSize)
+    {
+        int len = static_cast<int>(qMin<size_t>(BlockSize, n - base));
+        float *sp = stack.data();   // 다음에 넣을 위치
+
+        for (const Instruction *ins = begin; ins != end; ++ins)
+        {
+            switch (ins->op)
+            {
+            case PushConst:
+                VecMath::fill(sp, static_cast<float>(ins->value), len);
+                sp += BlockSize;
+                break;
+
+            case PushX:
+                VecMath::copy(sp, xs + base, len);
+                sp += BlockSize;
+                break;
+
+            case Add:
+                sp -= BlockSize;
+                VecMath::add(sp - BlockSize, sp, len);
+                break;
+
+            case Sub:
+                sp -= BlockSize;
+                VecMath::sub(sp - BlockSize, sp, len);
+                break;
+
+            case Mul:
+                sp -= BlockSize;
+                VecMath::mul(sp - BlockSize, sp, len);
+                break;
+
+            case Div:
+                sp -= BlockSize;
+                VecMath::div(sp - BlockSize, sp, len);
+                break;
+
+            case Pow:
+                sp -= BlockSize;
+                VecMath::pow(sp - BlockSize, sp, len);
+                break;
+
+            case Neg:
+                VecMath::neg(sp - BlockSize, len);
+                break;
+
+            case PowInt:
+                VecMath::powInt(sp - BlockSize, static_cast<int>(ins->value),
+                                len);
+                break;
+            }
+        }
+
+        VecMath::copy(ys + base, stack.data(), len);
+    }
+}
+
+/**
+ * @brief 여러 x 값에 대해 다항식을 double 로 한꺼번에 계산한다
+ * @param xs x 값 배열
+ * @param ys 계산 결과를 저장할 배열
+ * @param n 개수
+ */
+void PolyCalc::evalBatch(const double *xs, double *ys, size_t n) const
+{
+    runBatch(xs, ys, n);
+}
+
+/**
+ * @brief 여러 x 값에 대해 다항식을 long double 로 한꺼번에 계산한다
+ * @param xs x 값 배열
+ * @param ys 계산 결과를 저장할 배열
+ * @param n 개수
+ */
+void PolyCalc::evalBatch(const long double *xs, long double *ys,
+                         size_t n) const
+{
+    runBatch(xs, ys, n);
+}
+
+/**
+ * @brief double x 값들에 대해 주어진 정밀도로 다항식을 계산한다
+ * @param xs x 값 배열
+ * @param ys 계산 결과를 저장할 배열
+ * @param n 개수
+ * @param precision 계산 정밀도. AutoPrecision 이면 choosePrecision() 으로
+ *                  고름
+ */
+void PolyCalc::evalBatch(const double *xs, float *ys, size_t n,
+                         Precision precision) const
+{
+    if (precision == AutoPrecision)
+        precision = choosePrecision(xs, n);
+
+    switch (precision)
+    {
+    case DoublePrecision:
+        evalAs<double>(*this, xs, ys, n);
+        break;
+
+    case ExtendedPrecision:
+        evalAs<long double>(*this, xs, ys, n);
+        break;
+
+    default:
+        evalAs<float>(*this, xs, ys, n);
+        break;
+    }
+}
+
+/**
+ * @brief x 값들을 계산하기에 충분한 가장 좁은 정밀도를 고른다
+ * @param xs x 값 배열. 정렬되어 있어야 함
+ * @param n 개수
+ * @return 고른 정밀도
+ * @remark float 로 이웃한 x 값을 구별할 수 없으면 double 을 고른다.
+ *         그렇지 않으면 몇 개의 x 값에서 좁은 형과 넓은 형의 결과를 견주어,
+ *         차이가 결과 범위의 ProbeTolerance 배를 넘을 때만 넓힌다.
+ */
+PolyCalc::Precision PolyCalc::choosePrecision(const double *xs,
+                                              size_t n) const
+{
+    enum { MaxProbes = 16 };
+
+    static const double ProbeTolerance = 1e-4;
+
+    if (n == 0)
+        return SinglePrecision;
+
+    bool narrowX = false;
+
+    for (size_t i = 1; i < n && !narrowX; ++i)
+        narrowX = xs[i] != xs[i - 1]
+                  && static_cast<float>(xs[i]) == static_cast<float>(xs[i - 1]);
+
+    // 고르게 흩어진 몇 개의 x 값에서 세 정밀도로 계산
+    size_t step = qMax<size_t>(n / MaxProbes, 1);
+    float singleError = 0;
+    long double doubleError = 0;
+    long double yMin = 0;
+    long double yMax = 0;
+    bool found = false;
+
+    for (size_t i = 0; i < n; i += step)
+    {
+        long double exact = calc(static_cast<long double>(xs[i]));
+
+        if (!qIsFinite(static_cast<double>(exact)))
+            continue;
+
+        float single = calc(static_cast<float>(xs[i]));
+        double wide = calc(xs[i]);
+
+        singleError = qMax(singleError,
+                           static_cast<float>(std::fabs(single - exact)));
+        doubleError = qMax(doubleError, std::fabs(wide - exact));
+
+        yMin = found ? qMin(yMin, exact) : exact;
+        yMax = found ? qMax(yMax, exact) : exact;
+        found = true;
+    }
+
+    // 상수 함수이면 값의 크기와 견줌
+    long double scale = yMax > yMin ? yMax - yMin
+                                    : qMax(std::fabs(yMin), std::fabs(yMax));
+    long double bound = scale * ProbeTolerance;
+
+    if (doubleError > bound)
+        return ExtendedPrecision;
+
+    // float 의 오차가 NaN 이나 inf 이면 넘친 것이므로 넓힘
+    if (narrowX || !(singleError <= bound))
+        return DoublePrecision;
+
+    return SinglePrecision;
+}
+
+/**
+ * @brief 주어진 x 값으로 다항식과 미분값을 함께 계산한다
+ * @param x x 값
+ * @param derivative 미분값을 돌려받음
+ * @return 계산 결과를 돌려준다
+ * @remark 이원수로 한 번에 계산한다
+ */
+double PolyCalc::calc(double x, double *derivative) const
+{
+    Dual<double> r = run(Dual<double>(x, 1));
+
+    *derivative = r.derivative();
+
+    return r.value();
+}
+
+/**
+ * @brief 여러 x 값에 대해 다항식과 미분값을 한꺼번에 계산한다
+ * @param xs x 값 배열
+ * @param ys 계산 결과를 저장할 배열
+ * @param derivatives 미분값을 저장할 배열
+ * @param n 개수
+ * @remark 이원수 배열로 스택 기계를 한 번만 실행한다
+ */
+void PolyCalc::evalDual(const double *xs, double *ys, double *derivatives,
+                        size_t n) const
+{
+    enum { ChunkSize = 256 };
+
+    Dual<double> in[ChunkSize];
+    Dual<double> out[ChunkSize];
+
+    for (size_t base = 0; base < n; base += ChunkSize)
+    {
+        size_t len = qMin<size_t>(ChunkSize, n - base);
+
+        for (size_t i = 0; i < len; ++i)
+            in[i] = Dual<double>(xs[base + i], 1);
+
+        runBatch(in, out, len);
+
+        for (size_t i = 0; i < len; ++i)
+        {
+            ys[base + i] = out[i].value();
+            derivatives[base + i] = out[i].derivative();
+        }
+    }
+}
+
+/**
+ * @brief 여러 x 값에 대해 도함수를 계산한다
+ * @param xs x 값 배열
+ * @param ys 미분값을 저장할 배열
+ * @param n 개수
+ */
+void PolyCalc::evalDerivative(const double *xs, float *ys, size_t n) const
+{
+    enum { ChunkSize = 256 };
+
+    double values[ChunkSize];
+    double derivatives[ChunkSize];
+
+    for (size_t base = 0; base < n; base += ChunkSize)
+    {
+        size_t len = qMin<size_t>(ChunkSize, n - base);
+
+        evalDual(xs + base, values, derivatives, len);
+
+        std::copy(derivatives, derivatives + len, ys + base);
+    }
+}
+
+/**
+ * @brief 다항식인지 알려준다
+ * @return 나누기나 실수 거듭제곱, 음의 정수 거듭제곱이 없으면 true,
+ *         아니면 false
+ * @remark 다항식은 모든 곳에서 연속이고 미분할 수 있으므로, 범위 안의
+ *         최댓값과 최솟값은 양 끝과 극값 중에 있다
+ */
+bool PolyCalc::isPolynomial() const
+{
+    foreach (const Instruction &ins, _code)
+    {
+        switch (ins.op)
+        {
+        case Div:
+        case Pow:
+            return false;
+
+        case PushConst:
+            if (!qIsFinite(ins.value))
+                return false;
+            break;
+
+        case PowInt:
+            if (ins.value < 0)
+                return false;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return !_code.isEmpty();
+}
+
+/**
+ * @brief 다항식의 부호가 바뀌는 구간에서 근을 찾는다
+ * @param a 구간 시작
+ * @param b 구간 끝
+ * @param x 찾은 근을 돌려받음
+ * @return 찾았으면 true, 아니면 false
+ * @remark 미분값은 이원수로 같이 구한다
+ */
+bool PolyCalc::findRoot(double a, double b, double *x) const
+{
+    return solveBracketed([this](double t, double *d)
+    {
+        return calc(t, d);
+    }, a, b, x);
+}
+
+/**
+ * @brief 도함수의 부호가 바뀌는 구간에서 극값을 찾는다
+ * @param a 구간 시작
+ * @param b 구간 끝
+ * @param x 찾은 극점을 돌려받음
+ * @param curvature 극점에서의 2 계 미분값을 돌려받음. 양수이면 극소,
+ *                  음수이면 극대
+ * @return 찾았으면 true, 아니면 false
+ * @remark 2 계 미분값은 이원수의 이원수로 구한다
+ */
+bool PolyCalc::findExtremum(double a, double b, double *x,
+                            double *curvature) const
+{
+    typedef Dual<Dual<double> > Dual2;
+
+    auto derivative = [this](double t, double *d)
+    {
+        Dual2 r = run(Dual2(Dual<double>(t, 1), Dual<double>(1, 0)));
+
+        *d = r.derivative().derivative();
+
+        return r.derivative().value();
+    };
+
+    if (!solveBracketed(derivative, a, b, x))
+        return false;
+
+    derivative(*x, curvature);
+
+    return true;
+}
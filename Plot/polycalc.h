@@ -0,0 +1,202 @@
+/****************************************************************************
+**
+** polycalc.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef POLYCALC_H
+#define POLYCALC_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include <cstddef>
+
+class PolyJit;
+
+/**
+ * @brief 다항식 계산기
+ *
+ * 다항식은 setPoly() 에서 한 번만 파싱되어 명령어 배열로 컴파일되고
+ * PolyOptimizer 로 최적화된다. calc() 는 그 명령어 배열을 스택 기계로
+ * 실행한다. 여러 x 값을 한꺼번에 계산할 때는 명령어마다 배열 전체를
+ * SIMD 로 처리하는 evalBatch() 를 사용한다.
+ *
+ * 계산은 float, double, long double 로 할 수 있다. float 의 evalBatch() 는
+ * SIMD 로 계산하고, 더 넓은 형은 같은 스택 기계를 템플릿으로 실행한다.
+ * 상수는 double 로 저장한다.
+ *
+ * 이원수로 계산하면 값과 미분값을 한 번에 얻는다. 이것으로 도함수를 그리고,
+ * 뉴턴 방법으로 근과 극값을 찾는다.
+ *
+ * 기계어 번역이 켜져 있고 번역할 수 있는 다항식이면, float 의 evalBatch() 는
+ * PolyJit 이 번역한 기계어로 계산한다. 번역된 기계어는 복사본끼리 함께 쓴다.
+ */
+class PolyCalc
+{
+public:
+    /**
+     * @brief 명령어 종류
+     */
+    enum OpCode
+    {
+        PushConst,  ///< 상수를 스택에 넣음
+        PushX,      ///< x 값을 스택에 넣음
+        Add,        ///< 더하기
+        Sub,        ///< 빼기
+        Mul,        ///< 곱하기
+        Div,        ///< 나누기
+        Pow,        ///< 거듭제곱
+        Neg,        ///< 부호 바꾸기
+        PowInt      ///< 정수 거듭제곱. 지수는 value 이고 곱셈으로 계산
+    };
+
+    /**
+     * @brief 계산 정밀도
+     */
+    enum Precision
+    {
+        AutoPrecision,      ///< 범위와 값의 크기에 따라 고름
+        SinglePrecision,    ///< float. SIMD 와 기계어 번역을 씀
+        DoublePrecision,    ///< double
+        ExtendedPrecision   ///< long double
+    };
+
+    /**
+     * @brief 명령어
+     */
+    struct Instruction
+    {
+        OpCode op;      ///< 명령어 종류
+        double value;   ///< PushConst 의 상수값, PowInt 의 지수
+    };
+
+    explicit PolyCalc(const QString &poly = QString());
+
+    void setPoly(const QString &poly);
+
+    /**
+     * @brief 다항식을 돌려준다
+     * @return 다항식
+     */
+    QString poly() const
+    {
+        return _poly;
+    }
+
+    /**
+     * @brief 컴파일된 명령어 배열을 돌려준다
+     * @return 명령어 배열
+     */
+    const QVector<Instruction> &code() const
+    {
+        return _code;
+    }
+
+    /**
+     * @brief 실행에 필요한 스택 크기를 돌려준다
+     * @return 스택 크기
+     */
+    int stackSize() const
+    {
+        return _stackSize;
+    }
+
+    /**
+     * @brief x 값을 설정한다
+     * @param x x 로 설정할 값
+     */
+    void setX(float x)
+    {
+        _x = x;
+    }
+
+    /**
+     * @brief 설정된 x 값으로 다항식을 계산한다
+     * @return 계산 결과를 돌려준다
+     */
+    float calc() const
+    {
+        return calc(_x);
+    }
+
+    float calc(float x) const;
+    double calc(double x) const;
+    long double calc(long double x) const;
+
+    void evalBatch(const float *xs, float *ys, size_t n) const;
+    void evalBatch(const double *xs, double *ys, size_t n) const;
+    void evalBatch(const long double *xs, long double *ys, size_t n) const;
+    void evalBatch(const double *xs, float *ys, size_t n,
+                   Precision precision) const;
+
+    Precision choosePrecision(const double *xs, size_t n) const;
+
+    double calc(double x, double *derivative) const;
+    void evalDual(const double *xs, double *ys, double *derivatives,
+                  size_t n) const;
+    void evalDerivative(const double *xs, float *ys, size_t n) const;
+
+    bool isPolynomial() const;
+    bool findRoot(double a, double b, double *x) const;
+    bool findExtremum(double a, double b, double *x, double *curvature) const;
+
+    /**
+     * @brief 기계어로 번역되었는지 알려준다
+     * @return 번역되었으면 true, 아니면 false
+     */
+    bool isJitCompiled() const
+    {
+        return !_jit.isNull();
+    }
+
+    /**
+     * @brief 이후에 컴파일할 다항식을 기계어로 번역할지 설정한다
+     * @param enabled true 이면 번역하고, false 이면 스택 기계로만 계산
+     */
+    static void setJitEnabled(bool enabled)
+    {
+        _jitEnabled = enabled;
+    }
+
+    /**
+     * @brief 기계어 번역 여부를 돌려준다
+     * @return 번역하면 true, 아니면 false
+     */
+    static bool jitEnabled()
+    {
+        return _jitEnabled;
+    }
+
+private:
+    QString _poly;              ///< 다항식
+    QVector<Instruction> _code; ///< 컴파일된 명령어 배열
+    int _stackSize;             ///< 실행에 필요한 스택 크기
+    float _x;                   ///< x 값
+
+    QSharedPointer<PolyJit> _jit;   ///< 번역된 기계어. 없으면 스택 기계로 계산
+
+    static bool _jitEnabled;    ///< 기계어 번역 여부
+
+    template <typename T> T run(T x) const;
+    template <typename T> void runBatch(const T *xs, T *ys, size_t n) const;
+};
+
+#endif // POLYCALC_H
@@ -0,0 +1,405 @@
+/****************************************************************************
+**
+** polyjit.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#include "polyjit.h"
+
+#include <QByteArray>
+
+#include <cstring>
+
+#if defined(Q_PROCESSOR_X86_64) && defined(Q_OS_UNIX)
+#define POLYJIT_X86_64
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+/**
+ * @brief 레지스터로 쓸 수 있는 스택 칸 수. xmm15 는 임시 레지스터
+ */
+const int MaxStackSlots = 15;
+
+/**
+ * @brief x86-64 SSE 기계어 생성기
+ *
+ * 상수 표를 먼저 쓰고 그 뒤에 기계어를 쓴다. 상수는 RIP 기준 주소로
+ * 읽는다. 함수 인수는 System V 규약에 따라 rdi = xs, rsi = ys, rdx = n
+ * 이고, rax 는 바이트 단위의 현재 위치이다.
+ */
+class Emitter
+{
+public:
+    enum Register { Rsi = 6, Rdi = 7 };     ///< 주소에 쓰는 레지스터 번호
+
+    enum SseOp                              ///< 0F 로 시작하는 SSE 명령
+    {
+        MovupsLoad = 0x10,
+        MovupsStore = 0x11,
+        Movaps = 0x28,
+        Xorps = 0x57,
+        Addps = 0x58,
+        Mulps = 0x59,
+        Subps = 0x5C,
+        Divps = 0x5E
+    };
+
+    /**
+     * @brief Emitter 생성자
+     */
+    Emitter()
+        : _tableSize(0)
+    {
+    }
+
+    /**
+     * @brief 4 개로 복제한 상수를 상수 표에 넣는다
+     * @param value 상수
+     * @return 상수 표 안의 위치
+     * @remark 기계어를 쓰기 전에 모든 상수를 넣어야 한다
+     */
+    int constant(float value)
+    {
+        for (int offset = 0; offset < _tableSize; offset += 16)
+        {
+            // 비트가 같아야 같은 상수. 0 과 -0 은 다름
+            if (!memcmp(_bytes.constData() + offset, &value, sizeof(value)))
+                return offset;
+        }
+
+        Q_ASSERT(_tableSize == _bytes.size());
+
+        for (int i = 0; i < 4; ++i)
+            raw(reinterpret_cast<const char *>(&value), sizeof(value));
+
+        _tableSize += 16;
+
+        return _tableSize - 16;
+    }
+
+    /**
+     * @brief 현재 위치를 돌려준다
+     * @return 지금까지 쓴 바이트 수
+     */
+    int pos() const
+    {
+        return _bytes.size();
+    }
+
+    /**
+     * @brief 쓴 바이트들을 돌려준다
+     * @return 상수 표와 기계어
+     */
+    const QByteArray &bytes() const
+    {
+        return _bytes;
+    }
+
+    /**
+     * @brief 바이트들을 그대로 쓴다
+     * @param bytes 바이트들
+     * @param n 개수
+     */
+    void raw(const char *bytes, int n)
+    {
+        _bytes.append(bytes, n);
+    }
+
+    /**
+     * @brief op xmm(dst), xmm(src) 를 쓴다
+     */
+    void sse(SseOp op, int dst, int src)
+    {
+        rex(dst, src);
+        byte(0x0F);
+        byte(op);
+        byte(0xC0 | (dst & 7) << 3 | (src & 7));
+    }
+
+    /**
+     * @brief op xmm(reg), [base + rax] 를 쓴다
+     */
+    void sseIndexed(SseOp op, int reg, Register base)
+    {
+        rex(reg, 0);
+        byte(0x0F);
+        byte(op);
+        byte((reg & 7) << 3 | 4);   // SIB 사용
+        byte(base);                 // 배율 1, 인덱스 rax
+    }
+
+    /**
+     * @brief op xmm(reg), [rip + 상수] 를 쓴다
+     * @param op 명령
+     * @param reg 레지스터 번호
+     * @param constant constant() 가 돌려준 위치
+     */
+    void sseConstant(SseOp op, int reg, int constant)
+    {
+        rex(reg, 0);
+        byte(0x0F);
+        byte(op);
+        byte((reg & 7) << 3 | 5);   // RIP 기준
+
+        // 다음 명령의 위치를 기준으로 함
+        dword(constant - (pos() + 4));
+    }
+
+    /**
+     * @brief 부호 있는 32 비트 값을 쓴다
+     */
+    void dword(qint32 value)
+    {
+        raw(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+private:
+    QByteArray _bytes;  ///< 상수 표와 기계어
+    int _tableSize;     ///< 상수 표의 바이트 수
+
+    void byte(int value)
+    {
+        _bytes.append(static_cast<char>(value));
+    }
+
+    /**
+     * @brief xmm8 이상을 쓰면 REX 접두사를 쓴다
+     */
+    void rex(int reg, int rm)
+    {
+        if (reg >= 8 || rm >= 8)
+            byte(0x40 | (reg >= 8) << 2 | (rm >= 8));
+    }
+};
+
+} // namespace
+
+/**
+ * @brief PolyJit 생성자
+ * @param memory 번역된 기계어가 있는 메모리
+ * @param size 메모리 크기
+ * @param kernel 번역된 함수
+ */
+PolyJit::PolyJit(void *memory, size_t size, Kernel kernel)
+    : _memory(memory)
+    , _size(size)
+    , _kernel(kernel)
+{
+}
+
+/**
+ * @brief PolyJit 소멸자
+ */
+PolyJit::~PolyJit()
+{
+#ifdef POLYJIT_X86_64
+    munmap(_memory, _size);
+#endif
+}
+
+/**
+ * @brief 이 환경에서 번역할 수 있는지 알려준다
+ * @return x86-64 System V 환경이면 true, 아니면 false
+ */
+bool PolyJit::isSupported()
+{
+#ifdef POLYJIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 명령어 배열을 기계어로 번역한다
+ * @param code 명령어 배열
+ * @param stackSize 실행에 필요한 스택 크기
+ * @return 번역된 다항식. 번역할 수 없으면 0
+ */
+PolyJit *PolyJit::compile(const QVector<PolyCalc::Instruction> &code,
+                          int stackSize)
+{
+#ifdef POLYJIT_X86_64
+    if (code.isEmpty() || stackSize > MaxStackSlots)
+        return 0;
+
+    Emitter e;
+
+    // 상수 표 만들기. 정수 지수가 아닌 거듭제곱이 있으면 번역하지 않음
+    int one = e.constant(1);
+    int signMask = e.constant(-0.0f);
+
+    foreach (const PolyCalc::Instruction &ins, code)
+    {
+        if (ins.op == PolyCalc::Pow)
+            return 0;
+
+        if (ins.op == PolyCalc::PushConst)
+            e.constant(static_cast<float>(ins.value));
+    }
+
+    int entry = e.pos();
+
+    e.raw("\x31\xC0", 2);           // xor eax, eax
+    e.raw("\x48\xC1\xE2\x02", 4);   // shl rdx, 2
+
+    int loop = e.pos();
+    int sp = 0;                     // 다음에 넣을 스택 칸
+
+    foreach (const PolyCalc::Instruction &ins, code)
+    {
+        switch (ins.op)
+        {
+        case PolyCalc::PushConst:
+            e.sseConstant(Emitter::MovupsLoad, sp++,
+                          e.constant(static_cast<float>(ins.value)));
+            break;
+
+        case PolyCalc::PushX:
+            e.sseIndexed(Emitter::MovupsLoad, sp++, Emitter::Rdi);
+            break;
+
+        case PolyCalc::Add:
+            --sp;
+            e.sse(Emitter::Addps, sp - 1, sp);
+            break;
+
+        case PolyCalc::Sub:
+            --sp;
+            e.sse(Emitter::Subps, sp - 1, sp);
+            break;
+
+        case PolyCalc::Mul:
+            --sp;
+            e.sse(Emitter::Mulps, sp - 1, sp);
+            break;
+
+        case PolyCalc::Div:
+            --sp;
+            e.sse(Emitter::Divps, sp - 1, sp);
+            break;
+
+        case PolyCalc::Neg:
+            e.sseConstant(Emitter::Xorps, sp - 1, signMask);
+            break;
+
+        case PolyCalc::PowInt:
+        {
+            // 제곱을 거듭하며 xmm15 에 곱함
+            int exponent = static_cast<int>(ins.value);
+            int n = qAbs(exponent);
+            int base = sp - 1;
+            bool first = true;
+
+            while (n)
+            {
+                if (n & 1)
+                {
+                    e.sse(first ? Emitter::Movaps : Emitter::Mulps, 15, base);
+                    first = false;
+                }
+
+                n >>= 1;
+
+                if (n)
+                    e.sse(Emitter::Mulps, base, base);
+            }
+
+            if (first)          // x^0 = 1
+                e.sseConstant(Emitter::MovupsLoad, base, one);
+            else if (exponent < 0)
+            {
+                // 1 / x^n
+                e.sseConstant(Emitter::MovupsLoad, base, one);
+                e.sse(Emitter::Divps, base, 15);
+            }
+            else
+                e.sse(Emitter::Movaps, base, 15);
+
+            break;
+        }
+
+        case PolyCalc::Pow:     // 위에서 걸러짐
+            return 0;
+        }
+    }
+
+    e.sseIndexed(Emitter::MovupsStore, 0, Emitter::Rsi);
+    e.raw("\x48\x83\xC0\x10", 4);   // add rax, 16
+    e.raw("\x48\x39\xD0", 3);       // cmp rax, rdx
+    e.raw("\x0F\x82", 2);           // jb loop
+    e.dword(loop - (e.pos() + 4));
+    e.raw("\xC3", 1);               // ret
+
+    // 쓰기 가능한 메모리에 복사한 뒤 실행 가능으로 바꿈
+    size_t size = e.bytes().size();
+    void *memory = mmap(0, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory == MAP_FAILED)
+        return 0;
+
+    memcpy(memory, e.bytes().constData(), size);
+
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(memory, size);
+
+        return 0;
+    }
+
+    return new PolyJit(memory, size,
+                       reinterpret_cast<Kernel>(
+                           static_cast<char *>(memory) + entry));
+#else
+    Q_UNUSED(code);
+    Q_UNUSED(stackSize);
+
+    return 0;
+#endif
+}
+
+/**
+ * @brief 여러 x 값에 대해 다항식을 한꺼번에 계산한다
+ * @param xs x 값 배열
+ * @param ys 계산 결과를 저장할 배열
+ * @param n 개수
+ */
+void PolyJit::evalBatch(const float *xs, float *ys, size_t n) const
+{
+    size_t full = n & ~static_cast<size_t>(3);
+
+    if (full)
+        _kernel(xs, ys, full);
+
+    // 4 개가 안 되는 나머지는 0 으로 채워서 계산
+    if (full < n)
+    {
+        float restXs[4] = {0, 0, 0, 0};
+        float restYs[4];
+
+        memcpy(restXs, xs + full, (n - full) * sizeof(float));
+
+        _kernel(restXs, restYs, 4);
+
+        memcpy(ys + full, restYs, (n - full) * sizeof(float));
+    }
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+**
+** polyjit.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef POLYJIT_H
+#define POLYJIT_H
+
+#include "polycalc.h"
+
+#include <QtGlobal>
+
+#include <cstddef>
+
+/**
+ * @brief 컴파일된 다항식의 기계어 번역기
+ *
+ * PolyCalc 의 명령어 배열을 x86-64 SSE 기계어로 바꾼다. 스택의 각 칸은
+ * xmm 레지스터 하나에 대응하고, x 값 4 개를 한꺼번에 계산한다. 명령어를
+ * 해석하는 비용도, 중간 결과를 메모리에 쓰는 비용도 없다.
+ *
+ * 정수 거듭제곱(PowInt)은 곱셈으로 풀어서 번역한다. 정수가 아닌
+ * 거듭제곱(Pow)이 있거나, 스택이 레지스터보다 깊거나, x86-64 System V 환경이
+ * 아니거나, 실행할 수 있는 메모리를 얻지 못하면 번역하지 않는다. 이때
+ * PolyCalc 는 스택 기계로 계산한다.
+ */
+class PolyJit
+{
+public:
+    ~PolyJit();
+
+    static bool isSupported();
+
+    static PolyJit *compile(const QVector<PolyCalc::Instruction> &code,
+                            int stackSize);
+
+    void evalBatch(const float *xs, float *ys, size_t n) const;
+
+private:
+    /**
+     * @brief 번역된 함수. n 은 4 의 배수
+     */
+    typedef void (*Kernel)(const float *xs, float *ys, size_t n);
+
+    void *_memory;      ///< 번역된 기계어가 있는 메모리
+    size_t _size;       ///< 메모리 크기
+    Kernel _kernel;     ///< 번역된 함수
+
+    PolyJit(void *memory, size_t size, Kernel kernel);
+
+    Q_DISABLE_COPY(PolyJit)
+};
+
+#endif // POLYJIT_H
@@ -0,0 +1,583 @@
+/****************************************************************************
+**
+** polyoptimizer.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#include "polyoptimizer.h"
+
+#include <cmath>
+
+/**
+ * @brief PolyOptimizer 생성자
+ * @param code 후위 표기법 순서의 명령어 배열
+ */
+PolyOptimizer::PolyOptimizer(const QVector<PolyCalc::Instruction> &code)
+    : _root(-1)
+{
+    // 스택 기계처럼 실행하면서 마디를 만듦
+    QVector<int> stack;
+
+    foreach (const PolyCalc::Instruction &ins, code)
+    {
+        switch (ins.op)
+        {
+        case PolyCalc::PushConst:
+        case PolyCalc::PushX:
+            stack.append(node(ins.op, ins.value));
+            break;
+
+        case PolyCalc::Neg:
+        case PolyCalc::PowInt:
+            stack.last() = node(ins.op, ins.value, stack.last());
+            break;
+
+        default:    // 이항 연산자
+        {
+            int right = stack.takeLast();
+
+            stack.last() = node(ins.op, 0, stack.last(), right);
+            break;
+        }
+        }
+    }
+
+    if (!stack.isEmpty())
+        _root = stack.last();
+}
+
+/**
+ * @brief 최적화한다
+ * @return 최적화된 명령어 배열
+ */
+QVector<PolyCalc::Instruction> PolyOptimizer::optimize()
+{
+    QVector<PolyCalc::Instruction> code;
+
+    if (_root < 0)
+        return code;
+
+    _root = toHorner(simplify(_root));
+
+    generate(_root, &code);
+
+    return code;
+}
+
+/**
+ * @brief 마디를 만든다
+ * @param op 연산 종류
+ * @param value 상수값 또는 지수
+ * @param left 왼쪽 피연산자
+ * @param right 오른쪽 피연산자
+ * @return 만든 마디
+ */
+int PolyOptimizer::node(PolyCalc::OpCode op, double value, int left, int right)
+{
+    Node n;
+
+    n.op = op;
+    n.value = value;
+    n.left = left;
+    n.right = right;
+
+    _nodes.append(n);
+
+    return _nodes.size() - 1;
+}
+
+/**
+ * @brief 상수 마디를 만든다
+ * @param value 상수값
+ * @return 만든 마디
+ */
+int PolyOptimizer::constant(double value)
+{
+    return node(PolyCalc::PushConst, value);
+}
+
+/**
+ * @brief 마디가 주어진 상수인지 알려준다
+ * @param n 마디
+ * @param value 상수값
+ * @return 상수이고 값이 같으면 true, 아니면 false
+ */
+bool PolyOptimizer::isConstant(int n, double value) const
+{
+    return _nodes.at(n).op == PolyCalc::PushConst
+            && _nodes.at(n).value == value;
+}
+
+/**
+ * @brief 유한한 모든 x 에 대해 값이 유한한지 알려준다
+ * @param n 마디
+ * @return 나누기와 정수가 아닌 거듭제곱이 없으면 true
+ * @remark 너무 커서 넘치는 경우는 생각하지 않는다
+ */
+bool PolyOptimizer::isFinite(int n) const
+{
+    const Node &nd = _nodes.at(n);
+
+    switch (nd.op)
+    {
+    case PolyCalc::PushConst:
+        return qIsFinite(nd.value);
+
+    case PolyCalc::PushX:
+        return true;
+
+    case PolyCalc::Neg:
+        return isFinite(nd.left);
+
+    case PolyCalc::PowInt:
+        return nd.value >= 0 && isFinite(nd.left);
+
+    case PolyCalc::Add:
+    case PolyCalc::Sub:
+    case PolyCalc::Mul:
+        return isFinite(nd.left) && isFinite(nd.right);
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 마디를 계산하는 명령어 수를 구한다
+ * @param n 마디
+ * @return 명령어 수
+ */
+int PolyOptimizer::size(int n) const
+{
+    const Node &nd = _nodes.at(n);
+
+    return 1 + (nd.left < 0 ? 0 : size(nd.left))
+             + (nd.right < 0 ? 0 : size(nd.right));
+}
+
+/**
+ * @brief 상수를 미리 계산하고 항등 연산을 없앤다
+ * @param n 마디
+ * @return 간단해진 마디
+ */
+int PolyOptimizer::simplify(int n)
+{
+    Node nd = _nodes.at(n);
+
+    switch (nd.op)
+    {
+    case PolyCalc::PushConst:
+    case PolyCalc::PushX:
+        return n;
+
+    case PolyCalc::Neg:
+    case PolyCalc::PowInt:
+        return simplifyUnary(n, simplify(nd.left));
+
+    default:
+    {
+        int a = simplify(nd.left);
+        int b = simplify(nd.right);
+
+        return simplifyBinary(n, a, b);
+    }
+    }
+}
+
+/**
+ * @brief 간단해진 피연산자로 단항 연산 마디를 간단히 한다
+ * @param n 원래 마디
+ * @param a 간단해진 피연산자
+ * @return 간단해진 마디
+ */
+int PolyOptimizer::simplifyUnary(int n, int a)
+{
+    // node() 가 _nodes 를 늘리므로 복사해 둠
+    Node nd = _nodes.at(n);
+    Node na = _nodes.at(a);
+
+    if (nd.op == PolyCalc::Neg)
+    {
+        if (na.op == PolyCalc::PushConst)   // -c
+            return constant(-na.value);
+
+        if (na.op == PolyCalc::Neg)         // -(-a) = a
+            return na.left;
+
+        return node(PolyCalc::Neg, 0, a);
+    }
+
+    // PowInt
+    if (nd.value == 1)
+        return a;
+
+    if (nd.value == 0)
+        return constant(1);
+
+    return node(PolyCalc::PowInt, nd.value, a);
+}
+
+/**
+ * @brief 간단해진 피연산자로 이항 연산 마디를 간단히 한다
+ * @param n 원래 마디
+ * @param a 간단해진 왼쪽 피연산자
+ * @param b 간단해진 오른쪽 피연산자
+ * @return 간단해진 마디
+ */
+int PolyOptimizer::simplifyBinary(int n, int a, int b)
+{
+    // node() 가 _nodes 를 늘리므로 복사해 둠
+    PolyCalc::OpCode op = _nodes.at(n).op;
+    Node na = _nodes.at(a);
+    Node nb = _nodes.at(b);
+
+    // 상수끼리의 연산은 상수를 저장하는 double 로 미리 계산
+    if (na.op == PolyCalc::PushConst && nb.op == PolyCalc::PushConst)
+    {
+        double x = na.value;
+        double y = nb.value;
+
+        switch (op)
+        {
+        case PolyCalc::Add: return constant(x + y);
+        case PolyCalc::Sub: return constant(x - y);
+        case PolyCalc::Mul: return constant(x * y);
+        case PolyCalc::Div: return constant(x / y);
+        case PolyCalc::Pow: return constant(std::pow(x, y));
+        default:            break;
+        }
+    }
+
+    switch (op)
+    {
+    case PolyCalc::Add:
+        if (isConstant(b, 0))           // a + 0
+            return a;
+
+        if (isConstant(a, 0))           // 0 + b
+            return b;
+
+        break;
+
+    case PolyCalc::Sub:
+        if (isConstant(b, 0))           // a - 0
+            return a;
+
+        if (isConstant(a, 0))           // 0 - b
+            return simplifyUnary(node(PolyCalc::Neg, 0, b), b);
+
+        break;
+
+    case PolyCalc::Mul:
+        if (isConstant(b, 1))           // a * 1
+            return a;
+
+        if (isConstant(a, 1))           // 1 * b
+            return b;
+
+        if (isConstant(b, -1))          // a * -1
+            return simplifyUnary(node(PolyCalc::Neg, 0, a), a);
+
+        if (isConstant(a, -1))          // -1 * b
+            return simplifyUnary(node(PolyCalc::Neg, 0, b), b);
+
+        // 0 * inf 는 NaN 이므로 항상 유한할 때만 0
+        if ((isConstant(a, 0) && isFinite(b))
+                || (isConstant(b, 0) && isFinite(a)))
+            return constant(0);
+
+        break;
+
+    case PolyCalc::Div:
+        if (isConstant(b, 1))           // a / 1
+            return a;
+
+        break;
+
+    case PolyCalc::Pow:
+        if (isConstant(a, 1))           // 1^b 는 NaN 이어도 1
+            return a;
+
+        if (nb.op == PolyCalc::PushConst && nb.value == std::floor(nb.value)
+                && qAbs(nb.value) <= MaxIntegerExponent)
+        {
+            // a^0 = 1, a^1 = a 도 여기서 처리됨
+            return simplifyUnary(node(PolyCalc::PowInt, nb.value, a), a);
+        }
+
+        break;
+
+    default:
+        break;
+    }
+
+    return node(op, 0, a, b);
+}
+
+/**
+ * @brief 단항식인지 알아보고 계수와 차수를 구한다
+ * @param n 마디
+ * @param coefficient 계수를 돌려받음
+ * @param degree 차수를 돌려받음
+ * @return c*x^k 꼴이면 true, 아니면 false
+ */
+bool PolyOptimizer::monomial(int n, double *coefficient, int *degree) const
+{
+    const Node &nd = _nodes.at(n);
+    double c1, c2;
+    int d1, d2;
+
+    switch (nd.op)
+    {
+    case PolyCalc::PushConst:
+        *coefficient = nd.value;
+        *degree = 0;
+        return qIsFinite(nd.value);
+
+    case PolyCalc::PushX:
+        *coefficient = 1;
+        *degree = 1;
+        return true;
+
+    case PolyCalc::Neg:
+        if (!monomial(nd.left, &c1, &d1))
+            return false;
+
+        *coefficient = -c1;
+        *degree = d1;
+        return true;
+
+    case PolyCalc::PowInt:
+        if (nd.value < 0 || !monomial(nd.left, &c1, &d1))
+            return false;
+
+        *coefficient = std::pow(c1, static_cast<int>(nd.value));
+        *degree = d1 * static_cast<int>(nd.value);
+        return *degree <= MaxIntegerExponent;
+
+    case PolyCalc::Mul:
+        if (!monomial(nd.left, &c1, &d1) || !monomial(nd.right, &c2, &d2))
+            return false;
+
+        *coefficient = c1 * c2;
+        *degree = d1 + d2;
+        return *degree <= MaxIntegerExponent;
+
+    case PolyCalc::Div:
+        if (!monomial(nd.left, &c1, &d1) || !monomial(nd.right, &c2, &d2)
+                || d2 != 0 || c2 == 0)
+            return false;
+
+        *coefficient = c1 / c2;
+        *degree = d1;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 단항식의 합인지 알아보고 차수별 계수를 구한다
+ * @param n 마디
+ * @param terms 차수별 계수를 돌려받음
+ * @return 단항식의 합이면 true, 아니면 false
+ * @remark 다항식끼리의 곱은 전개하지 않으므로 false 이다
+ */
+bool PolyOptimizer::polynomial(int n, Terms *terms) const
+{
+    const Node &nd = _nodes.at(n);
+    double c;
+    int d;
+
+    terms->clear();
+
+    if (monomial(n, &c, &d))
+    {
+        terms->insert(d, c);
+
+        return true;
+    }
+
+    Terms left, right;
+
+    switch (nd.op)
+    {
+    case PolyCalc::Neg:
+        if (!polynomial(nd.left, terms))
+            return false;
+
+        for (Terms::iterator it = terms->begin(); it != terms->end(); ++it)
+            it.value() = -it.value();
+
+        return true;
+
+    case PolyCalc::Add:
+    case PolyCalc::Sub:
+        if (!polynomial(nd.left, &left) || !polynomial(nd.right, &right))
+            return false;
+
+        *terms = left;
+
+        for (Terms::const_iterator it = right.constBegin();
+             it != right.constEnd(); ++it)
+        {
+            (*terms)[it.key()] += nd.op == PolyCalc::Add ? it.value()
+                                                         : -it.value();
+        }
+
+        return true;
+
+    case PolyCalc::Mul:
+    case PolyCalc::Div:
+        // 상수배만 허용
+        if (!monomial(nd.right, &c, &d) || d != 0
+                || !polynomial(nd.left, terms))
+        {
+            if (nd.op == PolyCalc::Div || !monomial(nd.left, &c, &d) || d != 0
+                    || !polynomial(nd.right, terms))
+                return false;
+        }
+
+        if (nd.op == PolyCalc::Div)
+        {
+            if (c == 0)
+                return false;
+
+            c = 1 / c;
+        }
+
+        for (Terms::iterator it = terms->begin(); it != terms->end(); ++it)
+            it.value() *= c;
+
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 단항식의 합인 부분을 Horner 꼴로 바꾼다
+ * @param n 마디
+ * @return 바뀐 마디. 명령어가 줄지 않으면 원래 마디
+ */
+int PolyOptimizer::toHorner(int n)
+{
+    Terms terms;
+
+    if (!polynomial(n, &terms))
+    {
+        // 피연산자 중에 다항식이 있을 수 있음
+        int left = _nodes.at(n).left;
+        int right = _nodes.at(n).right;
+
+        if (left >= 0)
+            left = toHorner(left);
+
+        if (right >= 0)
+            right = toHorner(right);
+
+        _nodes[n].left = left;
+        _nodes[n].right = right;
+
+        return n;
+    }
+
+    // 계수가 0 인 항은 뺌. 높은 차수부터
+    QVector<int> degrees;
+
+    for (Terms::const_iterator it = terms.constBegin();
+         it != terms.constEnd(); ++it)
+    {
+        if (it.value() != 0)
+            degrees.prepend(it.key());
+    }
+
+    if (degrees.isEmpty())
+        return constant(0);
+
+    // ((c0 * x^(d0-d1) + c1) * x^(d1-d2) + c2) ... * x^dn
+    int h = constant(terms.value(degrees.first()));
+
+    for (int i = 1; i < degrees.size(); ++i)
+    {
+        h = multiplyXPower(h, degrees.at(i - 1) - degrees.at(i));
+        h = node(PolyCalc::Add, 0, h, constant(terms.value(degrees.at(i))));
+    }
+
+    h = multiplyXPower(h, degrees.last());
+
+    return size(h) < size(n) ? h : n;
+}
+
+/**
+ * @brief x^degree 마디를 만든다
+ * @param degree 차수. 1 이상
+ * @return 만든 마디
+ */
+int PolyOptimizer::xPower(int degree)
+{
+    int x = node(PolyCalc::PushX);
+
+    return degree == 1 ? x : node(PolyCalc::PowInt, degree, x);
+}
+
+/**
+ * @brief 마디에 x^degree 를 곱한다
+ * @param n 마디
+ * @param degree 차수
+ * @return 곱한 마디
+ */
+int PolyOptimizer::multiplyXPower(int n, int degree)
+{
+    if (degree == 0)
+        return n;
+
+    if (isConstant(n, 1))
+        return xPower(degree);
+
+    if (isConstant(n, -1))
+        return node(PolyCalc::Neg, 0, xPower(degree));
+
+    return node(PolyCalc::Mul, 0, n, xPower(degree));
+}
+
+/**
+ * @brief 식 나무를 후위 표기법 순서의 명령어로 만든다
+ * @param n 마디
+ * @param code 명령어를 더할 배열
+ */
+void PolyOptimizer::generate(int n, QVector<PolyCalc::Instruction> *code) const
+{
+    const Node &nd = _nodes.at(n);
+
+    if (nd.left >= 0)
+        generate(nd.left, code);
+
+    if (nd.right >= 0)
+        generate(nd.right, code);
+
+    PolyCalc::Instruction ins;
+
+    ins.op = nd.op;
+    ins.value = nd.value;
+
+    code->append(ins);
+}
@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** polyoptimizer.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef POLYOPTIMIZER_H
+#define POLYOPTIMIZER_H
+
+#include "polycalc.h"
+
+#include <QMap>
+#include <QVector>
+
+/**
+ * @brief 컴파일된 다항식 최적화기
+ *
+ * 명령어 배열을 식 나무로 되돌린 뒤 다음을 적용하고, 다시 명령어 배열로
+ * 만든다.
+ *
+ * - 상수끼리의 연산은 상수를 저장하는 double 로 미리 계산한다. 그래서
+ *   float 로 계산할 때와 마지막 자리가 다를 수 있다
+ * - x*1, x+0, x^1 같은 항등 연산을 없앤다
+ * - 지수가 정수 상수인 거듭제곱은 곱셈으로 계산하는 PowInt 로 바꾼다
+ * - 단항식의 합인 부분은 Horner 꼴로 바꾼다
+ *
+ * 0*x 는 x 가 항상 유한한 값일 때만 0 으로 바꾸고, 다항식끼리의 곱이나
+ * 다항식의 거듭제곱은 전개하지 않는다. 전개하면 큰 계수끼리 상쇄되면서
+ * 정밀도를 잃을 수 있기 때문이다.
+ */
+class PolyOptimizer
+{
+public:
+    enum { MaxIntegerExponent = 64 };   ///< PowInt 로 바꿀 가장 큰 지수
+
+    explicit PolyOptimizer(const QVector<PolyCalc::Instruction> &code);
+
+    QVector<PolyCalc::Instruction> optimize();
+
+private:
+    /**
+     * @brief 식 나무의 마디
+     */
+    struct Node
+    {
+        PolyCalc::OpCode op;    ///< 연산 종류
+        double value;           ///< PushConst 의 상수값, PowInt 의 지수
+        int left;               ///< 왼쪽 피연산자. 없으면 -1
+        int right;              ///< 오른쪽 피연산자. 없으면 -1
+    };
+
+    typedef QMap<int, double> Terms;    ///< 차수별 계수
+
+    QVector<Node> _nodes;   ///< 식 나무의 마디들
+    int _root;              ///< 뿌리 마디
+
+    int node(PolyCalc::OpCode op, double value = 0,
+             int left = -1, int right = -1);
+    int constant(double value);
+    bool isConstant(int n, double value) const;
+    bool isFinite(int n) const;
+    int size(int n) const;
+
+    int simplify(int n);
+    int simplifyUnary(int n, int a);
+    int simplifyBinary(int n, int a, int b);
+
+    bool monomial(int n, double *coefficient, int *degree) const;
+    bool polynomial(int n, Terms *terms) const;
+
+    int toHorner(int n);
+    int xPower(int degree);
+    int multiplyXPower(int n, int degree);
+
+    void generate(int n, QVector<PolyCalc::Instruction> *code) const;
+};
+
+#endif // POLYOPTIMIZER_H
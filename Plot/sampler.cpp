@@ -0,0 +1,626 @@
+/****************************************************************************
+**
+** sampler.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#include "sampler.h"
+
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief AdaptiveSampler 생성자
+ * @param polyCalcs 계산할 다항식들
+ */
+AdaptiveSampler::AdaptiveSampler(const QVector<PolyCalc> &polyCalcs)
+    : _polyCalcs(polyCalcs)
+    , _errorBound(0.5f)
+    , _maxDepth(8)
+    , _precision(PolyCalc::AutoPrecision)
+    , _derivatives(false)
+    , _marks(false)
+{
+}
+
+/**
+ * @brief 화면 크기에 맞추어 표본을 뽑는다
+ * @param start 시작값
+ * @param end 끝값
+ * @param width 픽셀 단위의 폭
+ * @param height 픽셀 단위의 높이
+ * @return 다항식마다 곡선 표본
+ * @remark 스레드 풀에서 동시에 계산하며, 계산이 끝날 때까지 기다린다
+ */
+QVector<CurveSamples> AdaptiveSampler::sample(double start, double end,
+                                              int width, int height) const
+{
+    int level = tileLevel((end - start) / qMax(width, 1));
+
+    qint64 first, last;
+
+    tileRange(level, start, end, &first, &last);
+
+    QVector<SampleTile> tiles;
+
+    for (qint64 index = first; index <= last; ++index)
+    {
+        SampleTile tile;
+
+        tile.level = level;
+        tile.index = index;
+        tile.tolerance = -1;
+
+        tiles.append(tile);
+    }
+
+    return sampleTiles(tiles, start, end, height).curves;
+}
+
+/**
+ * @brief 타일들을 계산하고 보이는 범위의 표본으로 이어 붙인다
+ * @param tiles 보이는 범위를 덮는 이웃한 타일들. 이미 계산된 타일은
+ *              계산하지 않음
+ * @param start 보이는 범위의 시작값
+ * @param end 보이는 범위의 끝값
+ * @param height 픽셀 단위의 높이
+ * @return 계산된 타일들과 다항식마다 보이는 범위의 표본
+ * @remark 스레드 풀에서 타일마다 동시에 계산하며, 계산이 끝날 때까지
+ *         기다린다
+ */
+TiledSamples AdaptiveSampler::sampleTiles(const QVector<SampleTile> &tiles,
+                                          double start, double end,
+                                          int height) const
+{
+    TiledSamples result;
+
+    result.tiles = tiles;
+
+    int polys = _polyCalcs.size();
+    int curves = curveCount();
+
+    // 1 단계: 새로 드러난 타일만 균등한 표본 계산
+    QtConcurrent::blockingMap(result.tiles, [=](SampleTile &tile)
+    {
+        if (!tile.xs.isEmpty())
+            return;
+
+        double spacing = tileSpacing(tile.level);
+        qint64 first = tile.index * TileIntervals;
+
+        // 누적 오차가 없도록 매번 표본 번호에서 계산
+        tile.xs.resize(TileIntervals + 1);
+
+        for (int i = 0; i <= TileIntervals; ++i)
+            tile.xs[i] = (first + i) * spacing;
+
+        // 가장 깊이 나눈 표본 간격을 float 로 구별할 수 없으면 넓힘
+        double reach = qMax(qAbs(tile.xs.first()), qAbs(tile.xs.last()));
+        bool narrowX = reach * std::numeric_limits<float>::epsilon()
+                       > std::ldexp(spacing, -_maxDepth);
+
+        int n = tile.xs.size();
+
+        tile.ys.resize(curves);
+        tile.precisions.fill(_precision, curves);
+        tile.points.resize(polys);
+
+        QVector<double> values(n);
+        QVector<double> slopes(n);
+
+        // 같은 x 격자에서 다항식마다 한 번씩 계산
+        for (int p = 0; p < polys; ++p)
+        {
+            const PolyCalc &polyCalc = _polyCalcs.at(p);
+            int c = curveOf(p);
+
+            // 다항식은 정확한 y 범위를 구하려고 극값을 늘 찾음. 미분값은
+            // 도함수 곡선을 그리거나 근과 극값을 찾을 때만 필요
+            bool search = _marks || polyCalc.isPolynomial();
+            bool dual = _derivatives || search;
+            PolyCalc::Precision &precision = tile.precisions[c];
+
+            if (precision == PolyCalc::AutoPrecision)
+            {
+                precision = polyCalc.choosePrecision(tile.xs.constData(), n);
+
+                if (narrowX && precision == PolyCalc::SinglePrecision)
+                    precision = PolyCalc::DoublePrecision;
+            }
+
+            tile.ys[c].resize(n);
+
+            if (!dual)
+            {
+                polyCalc.evalBatch(tile.xs.constData(), tile.ys[c].data(), n,
+                                   precision);
+
+                continue;
+            }
+
+            // 값과 미분값을 한 번에 계산
+            polyCalc.evalDual(tile.xs.constData(), values.data(),
+                              slopes.data(), n);
+
+            // 이원수는 double 이므로 long double 만 따로 계산
+            if (precision == PolyCalc::ExtendedPrecision)
+                polyCalc.evalBatch(tile.xs.constData(), tile.ys[c].data(), n,
+                                   precision);
+            else
+                std::copy(values.constBegin(), values.constEnd(),
+                          tile.ys[c].begin());
+
+            if (_derivatives)
+            {
+                tile.precisions[c + 1] = PolyCalc::DoublePrecision;
+                tile.ys[c + 1].resize(n);
+
+                std::copy(slopes.constBegin(), slopes.constEnd(),
+                          tile.ys[c + 1].begin());
+            }
+
+            if (search)
+                analyze(polyCalc, tile.xs, values, slopes, &tile.points[p]);
+        }
+    });
+
+    // 곡선마다 보이는 범위의 y 값 범위. 다항식은 양 끝과 극값으로 정확히
+    // 구하고, 나머지는 균등한 표본에서 찾음
+    QVector<char> exact(curves, 0);
+    QVector<char> ranged(curves, 0);
+    QVector<float> yMins(curves, 0);
+    QVector<float> yMaxs(curves, 0);
+
+    for (int c = 0; c < curves; ++c)
+    {
+        const PolyCalc &polyCalc = _polyCalcs.at(polyOf(c));
+
+        if (!isDerivative(c) && polyCalc.isPolynomial())
+        {
+            exact[c] = ranged[c] = exactRange(polyCalc, result.tiles,
+                                              polyOf(c), start, end,
+                                              &yMins[c], &yMaxs[c]);
+
+            continue;
+        }
+
+        foreach (const SampleTile &tile, result.tiles)
+        {
+            for (int i = 0; i < tile.xs.size(); ++i)
+            {
+                double x = tile.xs.at(i);
+                float y = tile.ys.at(c).at(i);
+
+                if (x < start || x > end || !qIsFinite(y))
+                    continue;
+
+                yMins[c] = ranged[c] ? qMin(yMins.at(c), y) : y;
+                yMaxs[c] = ranged[c] ? qMax(yMaxs.at(c), y) : y;
+                ranged[c] = true;
+            }
+        }
+    }
+
+    // 모든 곡선을 합친 범위
+    bool found = false;
+    float yMin = 0;
+    float yMax = 0;
+
+    for (int c = 0; c < curves; ++c)
+    {
+        if (!ranged.at(c))
+            continue;
+
+        yMin = found ? qMin(yMin, yMins.at(c)) : yMins.at(c);
+        yMax = found ? qMax(yMax, yMaxs.at(c)) : yMaxs.at(c);
+        found = true;
+    }
+
+    // 픽셀 단위 오차를 y 값 단위로 바꾸고, 2 의 거듭제곱으로 내림.
+    // 화면을 조금 옮겨 y 범위가 조금 바뀌어도 타일을 다시 나누지 않음
+    float tolerance = 0;
+    float breakJump = std::numeric_limits<float>::infinity();
+
+    if (found && yMax > yMin && _errorBound > 0)
+    {
+        int exponent;
+
+        std::frexp(_errorBound * (yMax - yMin) / qMax(height, 1), &exponent);
+
+        tolerance = std::ldexp(0.5f, exponent);
+        breakJump = tolerance * qMax(height, 1) / (2 * _errorBound);
+    }
+
+    // 2 단계: 허용 오차가 달라진 타일만 더 나눔
+    QtConcurrent::blockingMap(result.tiles, [=](SampleTile &tile)
+    {
+        if (tile.tolerance == tolerance)
+            return;
+
+        tile.refinedXs.fill(tile.xs, curves);
+        tile.refinedYs = tile.ys;
+
+        for (int c = 0; c < curves; ++c)
+            refine(_polyCalcs.at(polyOf(c)), isDerivative(c),
+                   tile.precisions.at(c),
+                   &tile.refinedXs[c], &tile.refinedYs[c],
+                   tolerance, breakJump);
+
+        tile.tolerance = tolerance;
+    });
+
+    // 곡선마다 타일 잇기. 이웃한 타일은 경계의 표본을 함께 가짐
+    result.curves.resize(curves);
+
+    for (int c = 0; c < curves; ++c)
+    {
+        QVector<double> xs;
+        QVector<float> ys;
+        QVector<CurvePoint> points;
+
+        for (int k = 0; k < result.tiles.size(); ++k)
+        {
+            const SampleTile &tile = result.tiles.at(k);
+            int skip = k == 0 ? 0 : 1;
+
+            xs += tile.refinedXs.at(c).mid(skip);
+            ys += tile.refinedYs.at(c).mid(skip);
+
+            // 근과 극값은 표시할 때 함수 곡선에만 담음
+            if (!_marks || isDerivative(c))
+                continue;
+
+            foreach (const CurvePoint &point, tile.points.at(polyOf(c)))
+            {
+                if (point.x >= start && point.x <= end)
+                    points.append(point);
+            }
+        }
+
+        // 보이는 범위와 그 바로 바깥의 표본 하나씩만 남김
+        int first = std::lower_bound(xs.constBegin(), xs.constEnd(), start)
+                    - xs.constBegin();
+        int last = std::upper_bound(xs.constBegin(), xs.constEnd(), end)
+                   - xs.constBegin();
+
+        first = qMax(first - 1, 0);
+        last = qMin(last + 1, xs.size());
+
+        CurveSamples &samples = result.curves[c];
+
+        samples.start = start;
+        samples.end = end;
+        samples.xs = xs.mid(first, last - first);
+        samples.ys = ys.mid(first, last - first);
+        samples.derivative = isDerivative(c);
+        samples.points = points;
+
+        // 정확한 범위가 없으면 더 나눈 표본에서 찾음
+        if (exact.at(c))
+        {
+            samples.hasRange = true;
+            samples.yMin = yMins.at(c);
+            samples.yMax = yMaxs.at(c);
+        }
+        else
+            samples.hasRange = finiteRange(samples.ys, &samples.yMin,
+                                           &samples.yMax);
+    }
+
+    return result;
+}
+
+/**
+ * @brief 균등한 표본에서 근과 극값을 찾는다
+ * @param polyCalc 계산할 다항식
+ * @param xs 균등한 표본 x 값
+ * @param values 표본 y 값
+ * @param slopes 표본 미분값
+ * @param points 찾은 근과 극값을 x 순서로 돌려받음
+ * @remark 값이나 미분값의 부호가 바뀌는 구간에서만 뉴턴 방법으로 찾는다.
+ *         이웃한 타일과 겹치지 않도록 마지막 표본 위의 점은 세지 않는다.
+ */
+void AdaptiveSampler::analyze(const PolyCalc &polyCalc,
+                              const QVector<double> &xs,
+                              const QVector<double> &values,
+                              const QVector<double> &slopes,
+                              QVector<CurvePoint> *points)
+{
+    points->clear();
+
+    for (int i = 0; i + 1 < xs.size(); ++i)
+    {
+        double a = xs.at(i);
+        double b = xs.at(i + 1);
+        double x;
+
+        // 근
+        double v0 = values.at(i);
+        double v1 = values.at(i + 1);
+
+        if (qIsFinite(v0) && qIsFinite(v1)
+                && (v0 == 0 || (v1 != 0 && (v0 < 0) != (v1 < 0)))
+                && polyCalc.findRoot(a, b, &x) && x < b)
+        {
+            CurvePoint point = {CurvePoint::Root, x, 0};
+
+            points->append(point);
+        }
+
+        // 극값. 2 계 미분값이 0 이면 변곡점
+        double s0 = slopes.at(i);
+        double s1 = slopes.at(i + 1);
+        double curvature;
+
+        if (qIsFinite(s0) && qIsFinite(s1)
+                && (s0 == 0 || (s1 != 0 && (s0 < 0) != (s1 < 0)))
+                && polyCalc.findExtremum(a, b, &x, &curvature) && x < b
+                && curvature != 0)
+        {
+            CurvePoint point = {curvature > 0 ? CurvePoint::Minimum
+                                              : CurvePoint::Maximum,
+                                x, static_cast<float>(polyCalc.calc(x))};
+
+            points->append(point);
+        }
+    }
+}
+
+/**
+ * @brief 다항식의 정확한 y 값 범위를 구한다
+ * @param polyCalc 계산할 다항식
+ * @param tiles 근과 극값을 찾은 타일들
+ * @param poly 다항식 번호
+ * @param start 범위의 시작값
+ * @param end 범위의 끝값
+ * @param yMin 최솟값을 돌려받음
+ * @param yMax 최댓값을 돌려받음
+ * @return 정의되는 값이 있으면 true, 아니면 false
+ * @remark 다항식은 연속이므로 최댓값과 최솟값은 양 끝과 극값 중에 있다
+ */
+bool AdaptiveSampler::exactRange(const PolyCalc &polyCalc,
+                                 const QVector<SampleTile> &tiles, int poly,
+                                 double start, double end,
+                                 float *yMin, float *yMax)
+{
+    QVector<float> ys;
+
+    ys.append(polyCalc.calc(start));
+    ys.append(polyCalc.calc(end));
+
+    foreach (const SampleTile &tile, tiles)
+    {
+        foreach (const CurvePoint &point, tile.points.at(poly))
+        {
+            if (point.kind != CurvePoint::Root
+                    && point.x >= start && point.x <= end)
+                ys.append(point.y);
+        }
+    }
+
+    return finiteRange(ys, yMin, yMax);
+}
+
+/**
+ * @brief 픽셀 간격에 맞는 확대 단계를 구한다
+ * @param unitsPerPixel 한 픽셀의 x 값 폭
+ * @return 확대 단계. 표본 간격이 한 픽셀보다 넓지 않은 가장 큰 단계
+ */
+int AdaptiveSampler::tileLevel(double unitsPerPixel)
+{
+    if (!(unitsPerPixel > 0))
+        return 0;
+
+    // 한 옥타브를 4 단계로 나눔
+    return qFloor(std::log2(unitsPerPixel) * 4);
+}
+
+/**
+ * @brief 확대 단계의 표본 간격을 구한다
+ * @param level 확대 단계
+ * @return 표본 간격
+ */
+double AdaptiveSampler::tileSpacing(int level)
+{
+    return std::exp2(level / 4.0);
+}
+
+/**
+ * @brief 범위를 덮는 타일 번호의 범위를 구한다
+ * @param level 확대 단계
+ * @param start 시작값
+ * @param end 끝값
+ * @param first 첫 타일 번호를 돌려받음
+ * @param last 마지막 타일 번호를 돌려받음
+ */
+void AdaptiveSampler::tileRange(int level, double start, double end,
+                                qint64 *first, qint64 *last)
+{
+    double tileWidth = tileSpacing(level) * TileIntervals;
+
+    *first = static_cast<qint64>(std::floor(start / tileWidth));
+    *last = qMax(*first, static_cast<qint64>(std::floor(end / tileWidth)));
+}
+
+/**
+ * @brief 중점이 직선에서 벗어난 구간을 나눌지 알려준다
+ * @param y0 구간 시작점의 y 값
+ * @param ym 구간 중점의 y 값
+ * @param y1 구간 끝점의 y 값
+ * @param tolerance 허용 오차
+ * @return 나누어야 하면 true, 아니면 false
+ */
+static inline bool needsSplit(float y0, float ym, float y1, float tolerance)
+{
+    int finites = qIsFinite(y0) + qIsFinite(ym) + qIsFinite(y1);
+
+    // 정의되는 값과 정의되지 않는 값이 섞여 있으면 경계를 찾아 나눔
+    if (finites != 3)
+        return finites != 0;
+
+    return qAbs(ym - (y0 + y1) / 2) > tolerance;
+}
+
+/**
+ * @brief 곡률이 크거나 불연속인 구간을 나누어 표본을 더한다
+ * @param polyCalc 계산할 다항식
+ * @param derivative true 이면 도함수를 계산
+ * @param precision 계산 정밀도. 도함수는 늘 이원수로 계산
+ * @param xs 표본 x 값. 정렬되어 있어야 하며, 더해진 표본이 끼워짐
+ * @param ys 표본 y 값
+ * @param tolerance y 값 단위의 허용 오차
+ * @param breakJump 가장 깊이 나눈 뒤에도 이보다 크게 뛰면 선을 끊음
+ * @remark 깊이마다 나눌 구간의 중점을 모아 한꺼번에 계산한다
+ */
+void AdaptiveSampler::refine(const PolyCalc &polyCalc, bool derivative,
+                             PolyCalc::Precision precision,
+                             QVector<double> *xs, QVector<float> *ys,
+                             float tolerance, float breakJump) const
+{
+    if (xs->size() < 2)
+        return;
+
+    // 구간마다 나누어 볼지 여부. 처음에는 모든 구간
+    QVector<char> active(xs->size() - 1, 1);
+
+    QVector<double> midXs;
+    QVector<float> midYs;
+
+    for (int depth = 0; depth < _maxDepth; ++depth)
+    {
+        // 살펴볼 구간의 중점 모으기
+        midXs.clear();
+
+        for (int i = 0; i < active.size(); ++i)
+        {
+            if (active.at(i))
+                midXs.append((xs->at(i) + xs->at(i + 1)) / 2);
+        }
+
+        if (midXs.isEmpty())
+            break;
+
+        midYs.resize(midXs.size());
+
+        if (derivative)
+            polyCalc.evalDerivative(midXs.constData(), midYs.data(),
+                                    midXs.size());
+        else
+            polyCalc.evalBatch(midXs.constData(), midYs.data(), midXs.size(),
+                               precision);
+
+        QVector<double> newXs;
+        QVector<float> newYs;
+        QVector<char> newActive;
+
+        newXs.reserve(xs->size() + midXs.size());
+        newYs.reserve(xs->size() + midXs.size());
+        newActive.reserve(newXs.capacity());
+
+        int m = 0;
+
+        for (int i = 0; i < active.size(); ++i)
+        {
+            newXs.append(xs->at(i));
+            newYs.append(ys->at(i));
+
+            if (!active.at(i))
+            {
+                newActive.append(0);
+
+                continue;
+            }
+
+            float ym = midYs.at(m);
+
+            if (needsSplit(ys->at(i), ym, ys->at(i + 1), tolerance))
+            {
+                // 중점을 끼우고 두 반쪽을 모두 다시 살펴봄
+                newXs.append(midXs.at(m));
+                newYs.append(ym);
+
+                newActive.append(1);
+                newActive.append(1);
+            }
+            else
+                newActive.append(0);
+
+            m++;
+        }
+
+        newXs.append(xs->last());
+        newYs.append(ys->last());
+
+        *xs = newXs;
+        *ys = newYs;
+        active = newActive;
+    }
+
+    // 끝까지 나누어도 크게 뛰는 구간은 불연속점으로 보고 선을 끊음
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    for (int i = active.size() - 1; i >= 0; --i)
+    {
+        if (!active.at(i))
+            continue;
+
+        float y0 = ys->at(i);
+        float y1 = ys->at(i + 1);
+
+        if (!qIsFinite(y0) || !qIsFinite(y1) || qAbs(y1 - y0) > breakJump)
+        {
+            xs->insert(i + 1, (xs->at(i) + xs->at(i + 1)) / 2);
+            ys->insert(i + 1, nan);
+        }
+    }
+}
+
+/**
+ * @brief 정의되는 y 값의 범위를 구한다
+ * @param ys y 값 배열
+ * @param yMin 최솟값을 돌려받음
+ * @param yMax 최댓값을 돌려받음
+ * @return 정의되는 값이 하나라도 있으면 true, 아니면 false
+ */
+bool AdaptiveSampler::finiteRange(const QVector<float> &ys,
+                                  float *yMin, float *yMax)
+{
+    bool found = false;
+
+    foreach (float y, ys)
+    {
+        if (!qIsFinite(y))
+            continue;
+
+        if (!found)
+        {
+            *yMin = *yMax = y;
+            found = true;
+        }
+        else if (y < *yMin)
+            *yMin = y;
+        else if (y > *yMax)
+            *yMax = y;
+    }
+
+    return found;
+}
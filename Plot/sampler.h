@@ -0,0 +1,322 @@
+/****************************************************************************
+**
+** sampler.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "polycalc.h"
+
+#include <QtGlobal>
+#include <QVector>
+
+/**
+ * @brief 곡선 위의 근이나 극값
+ */
+struct CurvePoint
+{
+    /**
+     * @brief 점 종류
+     */
+    enum Kind
+    {
+        Root,       ///< 근
+        Minimum,    ///< 극솟값
+        Maximum     ///< 극댓값
+    };
+
+    Kind kind;  ///< 점 종류
+    double x;   ///< x 값
+    float y;    ///< y 값
+};
+
+/**
+ * @brief 곡선 표본
+ */
+struct CurveSamples
+{
+    double start;       ///< 시작값
+    double end;         ///< 끝값
+    QVector<double> xs; ///< 표본 x 값
+    QVector<float> ys;  ///< 표본 y 값. 불연속점은 NaN
+    bool derivative;    ///< 도함수 곡선이면 true
+    bool hasRange;      ///< y 값 범위가 있으면 true
+    float yMin;         ///< 보이는 범위의 y 최솟값
+    float yMax;         ///< 보이는 범위의 y 최댓값
+    QVector<CurvePoint> points; ///< 보이는 범위의 근과 극값
+};
+
+/**
+ * @brief 표본 타일
+ *
+ * 확대 단계마다 x 축을 같은 크기의 타일로 나눈다. 타일의 표본 위치는
+ * 화면 위치와 관계없이 확대 단계와 타일 번호로만 정해지므로, 화면을
+ * 옮기거나 확대 단계를 되돌려도 이미 계산한 타일을 다시 쓸 수 있다.
+ *
+ * 균등한 표본 위치는 모든 곡선이 함께 쓰고, 더 나눈 표본은 곡선마다
+ * 따로 가진다. x 값은 넓은 범위나 깊은 확대에서도 위치를 잃지 않도록
+ * double 로 가진다.
+ */
+struct SampleTile
+{
+    int level;                  ///< 확대 단계
+    qint64 index;               ///< 타일 번호
+    QVector<double> xs;         ///< 균등한 표본 x 값. 비어 있으면 계산 전
+    QVector<QVector<float> > ys;    ///< 곡선마다 균등한 표본 y 값
+    QVector<PolyCalc::Precision> precisions;    ///< 곡선마다 계산한 정밀도
+    float tolerance;            ///< 더 나눌 때 쓴 허용 오차. 음수이면 나누기 전
+    QVector<QVector<double> > refinedXs;    ///< 곡선마다 더 나눈 표본 x 값
+    QVector<QVector<float> > refinedYs; ///< 곡선마다 더 나눈 표본 y 값.
+                                        ///< 불연속점은 NaN
+    QVector<QVector<CurvePoint> > points;   ///< 다항식마다 찾은 근과 극값
+};
+
+/**
+ * @brief 타일 단위로 계산한 결과
+ */
+struct TiledSamples
+{
+    QVector<SampleTile> tiles;      ///< 계산된 타일들
+    QVector<CurveSamples> curves;   ///< 곡선마다 타일들을 이어 붙인 보이는
+                                    ///< 범위의 표본
+};
+
+/**
+ * @brief 적응형 표본 추출기
+ *
+ * 먼저 화면 픽셀마다 표본을 하나씩 뽑은 뒤, 구간의 중점이 양 끝을 이은
+ * 직선에서 허용 오차보다 멀리 떨어진 구간, 또는 정의되지 않는 값이 섞인
+ * 구간만 반으로 나누어 다시 뽑는다. 가장 깊이 나눈 뒤에도 크게 뛰는 구간은
+ * 불연속점으로 보고 NaN 을 넣어 선을 끊는다.
+ *
+ * 여러 다항식을 함께 그릴 때는 모든 곡선이 같은 x 격자를 쓰고, 격자마다
+ * 다항식별로 한 번씩 일괄 계산한다. 허용 오차는 모든 곡선을 합친 y 범위로
+ * 정한다.
+ *
+ * 다항식은 타일과 곡선마다 정밀도를 골라 계산한다. 자동이면 보통은 float
+ * 로 SIMD 계산하고, 가장 깊이 나눈 표본 간격을 float 로 나타낼 수 없거나
+ * float 의 결과가 부정확할 때만 더 넓은 형으로 계산한다.
+ *
+ * 미분값이 필요하면 균등한 표본을 이원수로 계산하여 값과 미분값을 함께
+ * 얻는다. 도함수 곡선을 켜면 다항식마다 도함수 곡선이 바로 뒤에 붙는다.
+ * 근과 극값은 부호가 바뀌는 구간에서 찾는다. 다항식은 y 범위를 양 끝과
+ * 극값으로 정확히 구하므로 늘 찾고, 나머지 식은 근과 극값을 표시할 때만
+ * 찾는다. 미분값이 필요 없으면 evalBatch() 로 값만 계산한다.
+ *
+ * 범위는 타일로 나누어 스레드 풀에서 동시에 계산한다. 컴파일된
+ * 다항식은 계산 중에 상태를 바꾸지 않으므로 모든 스레드가 함께 쓴다.
+ * 추출기는 다항식을 값으로 가지므로, 복사본을 다른 스레드에 넘길 수 있다.
+ */
+class AdaptiveSampler
+{
+public:
+    enum { TileIntervals = 64 };    ///< 타일 하나의 균등한 구간 수
+
+    explicit AdaptiveSampler(
+            const QVector<PolyCalc> &polyCalcs = QVector<PolyCalc>());
+
+    /**
+     * @brief 계산할 다항식들을 설정한다
+     * @param polyCalcs 컴파일된 다항식들
+     */
+    void setPolyCalcs(const QVector<PolyCalc> &polyCalcs)
+    {
+        _polyCalcs = polyCalcs;
+    }
+
+    /**
+     * @brief 계산할 다항식들을 돌려준다
+     * @return 컴파일된 다항식들
+     */
+    const QVector<PolyCalc> &polyCalcs() const
+    {
+        return _polyCalcs;
+    }
+
+    /**
+     * @brief 허용 오차를 설정한다
+     * @param pixels 픽셀 단위의 허용 오차
+     */
+    void setErrorBound(float pixels)
+    {
+        _errorBound = pixels;
+    }
+
+    /**
+     * @brief 허용 오차를 돌려준다
+     * @return 픽셀 단위의 허용 오차
+     */
+    float errorBound() const
+    {
+        return _errorBound;
+    }
+
+    /**
+     * @brief 구간을 나누는 최대 깊이를 설정한다
+     * @param depth 최대 깊이. 한 픽셀은 최대 2^depth 개로 나누어짐
+     */
+    void setMaxDepth(int depth)
+    {
+        _maxDepth = depth;
+    }
+
+    /**
+     * @brief 구간을 나누는 최대 깊이를 돌려준다
+     * @return 최대 깊이
+     */
+    int maxDepth() const
+    {
+        return _maxDepth;
+    }
+
+    /**
+     * @brief 계산 정밀도를 설정한다
+     * @param precision 계산 정밀도
+     */
+    void setPrecision(PolyCalc::Precision precision)
+    {
+        _precision = precision;
+    }
+
+    /**
+     * @brief 계산 정밀도를 돌려준다
+     * @return 계산 정밀도
+     */
+    PolyCalc::Precision precision() const
+    {
+        return _precision;
+    }
+
+    /**
+     * @brief 도함수 곡선을 함께 계산할지 설정한다
+     * @param enabled true 이면 다항식마다 도함수 곡선을 바로 뒤에 붙임
+     */
+    void setDerivatives(bool enabled)
+    {
+        _derivatives = enabled;
+    }
+
+    /**
+     * @brief 도함수 곡선을 함께 계산하는지 돌려준다
+     * @return 계산하면 true, 아니면 false
+     */
+    bool derivatives() const
+    {
+        return _derivatives;
+    }
+
+    /**
+     * @brief 근과 극값을 곡선 표본에 담을지 설정한다
+     * @param enabled true 이면 곡선 표본마다 근과 극값을 찾아 담음
+     * @remark 다항식의 극값은 y 범위를 구하려고 설정과 관계없이 찾는다
+     */
+    void setMarks(bool enabled)
+    {
+        _marks = enabled;
+    }
+
+    /**
+     * @brief 근과 극값을 곡선 표본에 담는지 돌려준다
+     * @return 담으면 true, 아니면 false
+     */
+    bool marks() const
+    {
+        return _marks;
+    }
+
+    /**
+     * @brief 곡선 수를 돌려준다
+     * @return 곡선 수. 도함수 곡선을 함께 계산하면 다항식 수의 두 배
+     */
+    int curveCount() const
+    {
+        return _polyCalcs.size() * (_derivatives ? 2 : 1);
+    }
+
+    QVector<CurveSamples> sample(double start, double end,
+                                 int width, int height) const;
+
+    TiledSamples sampleTiles(const QVector<SampleTile> &tiles,
+                             double start, double end, int height) const;
+
+    static int tileLevel(double unitsPerPixel);
+    static double tileSpacing(int level);
+    static void tileRange(int level, double start, double end,
+                          qint64 *first, qint64 *last);
+
+    void refine(const PolyCalc &polyCalc, bool derivative,
+                PolyCalc::Precision precision,
+                QVector<double> *xs, QVector<float> *ys,
+                float tolerance, float breakJump) const;
+
+    static void analyze(const PolyCalc &polyCalc, const QVector<double> &xs,
+                        const QVector<double> &values,
+                        const QVector<double> &slopes,
+                        QVector<CurvePoint> *points);
+
+    static bool finiteRange(const QVector<float> &ys,
+                            float *yMin, float *yMax);
+
+private:
+    QVector<PolyCalc> _polyCalcs;   ///< 계산할 다항식들
+    float _errorBound;          ///< 픽셀 단위의 허용 오차
+    int _maxDepth;              ///< 구간을 나누는 최대 깊이
+    PolyCalc::Precision _precision; ///< 계산 정밀도
+    bool _derivatives;          ///< 도함수 곡선을 함께 계산하는지 여부
+    bool _marks;                ///< 근과 극값을 곡선 표본에 담는지 여부
+
+    /**
+     * @brief 곡선을 계산하는 다항식 번호를 돌려준다
+     * @param curve 곡선 번호
+     * @return 다항식 번호
+     */
+    int polyOf(int curve) const
+    {
+        return _derivatives ? curve / 2 : curve;
+    }
+
+    /**
+     * @brief 다항식의 곡선 번호를 돌려준다
+     * @param poly 다항식 번호
+     * @return 곡선 번호
+     */
+    int curveOf(int poly) const
+    {
+        return _derivatives ? poly * 2 : poly;
+    }
+
+    /**
+     * @brief 도함수 곡선인지 알려준다
+     * @param curve 곡선 번호
+     * @return 도함수 곡선이면 true, 아니면 false
+     */
+    bool isDerivative(int curve) const
+    {
+        return _derivatives && curve % 2 == 1;
+    }
+
+    static bool exactRange(const PolyCalc &polyCalc,
+                           const QVector<SampleTile> &tiles, int poly,
+                           double start, double end,
+                           float *yMin, float *yMax);
+};
+
+#endif // SAMPLER_H
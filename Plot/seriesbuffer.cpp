@@ -0,0 +1,86 @@
+/****************************************************************************
+**
+** seriesbuffer.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "seriesbuffer.h"
+
+#include <algorithm>
+
+/**
+ * @brief SeriesBuffer 생성자
+ * @param capacity 최대 점 수
+ */
+SeriesBuffer::SeriesBuffer(int capacity)
+    : _xs(qMax(capacity, 1))
+    , _ys(qMax(capacity, 1))
+    , _size(0)
+    , _total(0)
+{
+}
+
+/**
+ * @brief 모든 점을 버리고 번호를 처음부터 다시 센다
+ */
+void SeriesBuffer::clear()
+{
+    _size = 0;
+    _total = 0;
+}
+
+/**
+ * @brief 점들을 더한다
+ * @param xs x 값 배열
+ * @param ys y 값 배열
+ * @param n 점 수
+ * @remark 버퍼보다 많으면 남을 점들만 복사한다. 배열의 끝에서 나누어
+ *         두 번에 복사한다.
+ */
+void SeriesBuffer::append(const double *xs, const float *ys, int n)
+{
+    int cap = capacity();
+
+    // 어차피 덮어쓸 앞쪽 점들은 번호만 셈
+    if (n > cap)
+    {
+        _total += n - cap;
+        xs += n - cap;
+        ys += n - cap;
+        n = cap;
+    }
+
+    int done = 0;
+
+    while (done < n)
+    {
+        int pos = static_cast<int>(_total % cap);
+        int len = qMin(n - done, cap - pos);
+
+        std::copy(xs + done, xs + done + len, _xs.begin() + pos);
+        std::copy(ys + done, ys + done + len, _ys.begin() + pos);
+
+        _total += len;
+        done += len;
+    }
+
+    _size = static_cast<int>(qMin<qint64>(_size + static_cast<qint64>(n),
+                                          cap));
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+**
+** seriesbuffer.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef SERIESBUFFER_H
+#define SERIESBUFFER_H
+
+#include <QtGlobal>
+#include <QVector>
+
+/**
+ * @brief 데이터 점들의 고리 버퍼
+ *
+ * 크기가 정해진 배열에 점을 차례로 쓰고, 가득 차면 가장 오래된 점부터
+ * 덮어쓴다. 점에는 처음부터 센 번호가 붙고, 번호 i 인 점은 배열의
+ * i % capacity() 위치에 있다. 번호는 덮어써도 바뀌지 않으므로, 어디까지
+ * 그렸는지를 번호로 기억할 수 있다.
+ */
+class SeriesBuffer
+{
+public:
+    enum { DefaultCapacity = 1 << 20 };     ///< 기본 최대 점 수
+
+    explicit SeriesBuffer(int capacity = DefaultCapacity);
+
+    void clear();
+    void append(const double *xs, const float *ys, int n);
+
+    /**
+     * @brief 최대 점 수를 돌려준다
+     * @return 최대 점 수
+     */
+    int capacity() const
+    {
+        return _xs.size();
+    }
+
+    /**
+     * @brief 가지고 있는 점 수를 돌려준다
+     * @return 점 수
+     */
+    int size() const
+    {
+        return _size;
+    }
+
+    /**
+     * @brief 지금까지 더한 점 수를 돌려준다
+     * @return 점 수. 다음에 더할 점의 번호이기도 함
+     */
+    qint64 total() const
+    {
+        return _total;
+    }
+
+    /**
+     * @brief 가지고 있는 가장 오래된 점의 번호를 돌려준다
+     * @return 점 번호
+     */
+    qint64 firstIndex() const
+    {
+        return _total - _size;
+    }
+
+    /**
+     * @brief 덮어써서 버린 점이 있는지 알려준다
+     * @return 버린 점이 있으면 true, 아니면 false
+     */
+    bool hasWrapped() const
+    {
+        return _total > _size;
+    }
+
+    /**
+     * @brief 점의 x 값을 돌려준다
+     * @param index firstIndex() 이상 total() 미만인 점 번호
+     * @return x 값
+     */
+    double x(qint64 index) const
+    {
+        return _xs.at(static_cast<int>(index % _xs.size()));
+    }
+
+    /**
+     * @brief 점의 y 값을 돌려준다
+     * @param index firstIndex() 이상 total() 미만인 점 번호
+     * @return y 값
+     */
+    float y(qint64 index) const
+    {
+        return _ys.at(static_cast<int>(index % _ys.size()));
+    }
+
+private:
+    QVector<double> _xs;    ///< x 값 배열
+    QVector<float> _ys;     ///< y 값 배열
+    int _size;              ///< 가지고 있는 점 수
+    qint64 _total;          ///< 지금까지 더한 점 수
+};
+
+#endif // SERIESBUFFER_H
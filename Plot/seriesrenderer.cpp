@@ -0,0 +1,347 @@
+/****************************************************************************
+**
+** seriesrenderer.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "seriesrenderer.h"
+#include "graphrenderer.h"
+
+#include <QPainter>
+#include <QPolygonF>
+#include <QtMath>
+
+#include <limits>
+
+/**
+ * @brief 전체를 다시 그릴 때 오른쪽에 비워 둘 몫
+ * @remark 버퍼가 넘친 뒤에는 폭의 1/ScrollAhead 만큼씩 밀므로, 새 점이
+ *         들어올 때마다 밀지 않는다
+ */
+static const int ScrollAhead = 8;
+
+/**
+ * @brief SeriesRenderer 생성자
+ */
+SeriesRenderer::SeriesRenderer()
+    : _dpr(1)
+    , _pixmapValid(false)
+    , _drawn(0)
+    , _redrawCount(0)
+    , _xMin(0)
+    , _xMax(1)
+    , _yMin(-1)
+    , _yMax(1)
+    , _xScale(1)
+    , _yScale(1)
+{
+}
+
+/**
+ * @brief 모든 점을 버린다
+ */
+void SeriesRenderer::clear()
+{
+    _buffer.clear();
+
+    _drawn = 0;
+    _pixmapValid = false;
+}
+
+/**
+ * @brief 그릴 크기를 설정한다
+ * @param size 논리 픽셀 단위의 크기
+ * @param devicePixelRatio 장치 픽셀 비율
+ */
+void SeriesRenderer::setSize(const QSize &size, qreal devicePixelRatio)
+{
+    if (size == _size && devicePixelRatio == _dpr)
+        return;
+
+    _size = size;
+    _dpr = devicePixelRatio;
+
+    _pixmapValid = false;
+}
+
+/**
+ * @brief 점들을 더한다
+ * @param xs x 값 배열
+ * @param ys y 값 배열
+ * @param n 점 수
+ * @remark 그리기는 다음 paint() 까지 미루므로, 그 사이에 여러 번 더해도
+ *         한 번에 그린다
+ */
+void SeriesRenderer::append(const double *xs, const float *ys, int n)
+{
+    _buffer.append(xs, ys, n);
+}
+
+/**
+ * @brief 새 점들을 픽스맵에 그리고 픽스맵을 그린다
+ * @param painter 그릴 QPainter
+ */
+void SeriesRenderer::paint(QPainter *painter)
+{
+    if (isEmpty() || _size.isEmpty())
+        return;
+
+    if (!_pixmapValid)
+        redraw();
+    else
+        drawNew();
+
+    painter->drawPixmap(0, 0, _pixmap);
+}
+
+/**
+ * @brief 버퍼의 모든 점으로 범위를 정하고 픽스맵을 새로 그린다
+ */
+void SeriesRenderer::redraw()
+{
+    _redrawCount++;
+
+    _pixmap = QPixmap(_size * _dpr);
+    _pixmap.setDevicePixelRatio(_dpr);
+    _pixmap.fill(Qt::white);
+
+    qint64 first = _buffer.firstIndex();
+    qint64 last = _buffer.total();
+
+    // 정의되는 점들의 범위
+    double xLo = std::numeric_limits<double>::infinity();
+    double xHi = -xLo;
+    float yLo = std::numeric_limits<float>::infinity();
+    float yHi = -yLo;
+
+    for (qint64 i = first; i < last; ++i)
+    {
+        double x = _buffer.x(i);
+        float y = _buffer.y(i);
+
+        if (!qIsFinite(x) || !qIsFinite(y))
+            continue;
+
+        xLo = qMin(xLo, x);
+        xHi = qMax(xHi, x);
+        yLo = qMin(yLo, y);
+        yHi = qMax(yHi, y);
+    }
+
+    if (!(xLo <= xHi))
+    {
+        xLo = xHi = 0;
+        yLo = yHi = 0;
+    }
+
+    // 버퍼가 차는 동안에는 두 배로, 넘친 뒤에는 조금씩 밀어 가며 그림
+    double xSpan = xHi > xLo ? xHi - xLo : 1;
+
+    _xMin = xLo;
+    _xMax = _buffer.hasWrapped() ? xHi + xSpan / ScrollAhead
+                                 : xLo + 2 * xSpan;
+
+    // 위아래로 범위의 1/4 씩 여유를 둠
+    float yMargin = yHi > yLo ? (yHi - yLo) / 4 : qMax(qAbs(yHi), 1.0f);
+
+    _yMin = yLo - yMargin;
+    _yMax = yHi + yMargin;
+
+    updateScale();
+
+    QPainter painter(&_pixmap);
+
+    drawAxis(&painter, 0, _size.width());
+    drawPoints(&painter, first, last);
+
+    _drawn = last;
+    _pixmapValid = true;
+}
+
+/**
+ * @brief 마지막으로 그린 점부터 새 점들까지 이어 그린다
+ * @remark 새 점이 범위를 벗어나면 픽스맵을 밀거나 다시 그린다
+ */
+void SeriesRenderer::drawNew()
+{
+    qint64 total = _buffer.total();
+
+    if (_drawn >= total)
+        return;
+
+    // 이어 그릴 점을 이미 버렸으면 다시 그림
+    qint64 from = qMax<qint64>(_drawn - 1, 0);
+
+    if (from < _buffer.firstIndex())
+    {
+        redraw();
+
+        return;
+    }
+
+    // 새 점들의 범위
+    double xLo = std::numeric_limits<double>::infinity();
+    double xHi = -xLo;
+    float yLo = std::numeric_limits<float>::infinity();
+    float yHi = -yLo;
+
+    for (qint64 i = _drawn; i < total; ++i)
+    {
+        double x = _buffer.x(i);
+        float y = _buffer.y(i);
+
+        if (!qIsFinite(x) || !qIsFinite(y))
+            continue;
+
+        xLo = qMin(xLo, x);
+        xHi = qMax(xHi, x);
+        yLo = qMin(yLo, y);
+        yHi = qMax(yHi, y);
+    }
+
+    if (xLo < _xMin || yLo < _yMin || yHi > _yMax)
+    {
+        redraw();
+
+        return;
+    }
+
+    if (xHi > _xMax)
+    {
+        // 아직 버퍼가 차지 않았으면 모든 점이 보이도록 넓힘
+        if (!_buffer.hasWrapped())
+        {
+            redraw();
+
+            return;
+        }
+
+        scroll(xHi);
+
+        if (xHi > _xMax)
+        {
+            redraw();
+
+            return;
+        }
+    }
+
+    QPainter painter(&_pixmap);
+
+    drawPoints(&painter, from, total);
+
+    _drawn = total;
+}
+
+/**
+ * @brief x 값이 보이도록 픽스맵을 왼쪽으로 민다
+ * @param x 보여야 할 x 값
+ * @remark 폭보다 많이 밀어야 하면 밀지 않는다. 드러난 부분은 지우고
+ *         좌표축만 그린다.
+ */
+void SeriesRenderer::scroll(double x)
+{
+    double target = x + (_xMax - _xMin) / ScrollAhead;
+
+    // 장치 픽셀 단위로 밀어야 번지지 않음
+    int dx = qCeil((target - _xMax) * _xScale * _dpr);
+
+    if (dx >= _pixmap.width())
+        return;
+
+    _pixmap.scroll(-dx, 0, _pixmap.rect());
+
+    double shift = dx / (_xScale * _dpr);
+
+    _xMin += shift;
+    _xMax += shift;
+
+    qreal right = _size.width();
+    qreal left = right - dx / _dpr;
+
+    QPainter painter(&_pixmap);
+
+    painter.fillRect(QRectF(left, 0, right - left, _size.height()),
+                     Qt::white);
+
+    drawAxis(&painter, left, right);
+}
+
+/**
+ * @brief 보이면 x 축을 그린다
+ * @param painter 그릴 QPainter
+ * @param left 그릴 왼쪽 끝
+ * @param right 그릴 오른쪽 끝
+ */
+void SeriesRenderer::drawAxis(QPainter *painter, qreal left, qreal right)
+{
+    if (_yMin > 0 || _yMax < 0)
+        return;
+
+    qreal y = map(0, 0).y();
+
+    // 좌표축의 색깔은 검은색
+    painter->setPen(Qt::black);
+    painter->drawLine(QLineF(left, y, right, y));
+}
+
+/**
+ * @brief 점들을 이어 그린다
+ * @param painter 그릴 QPainter
+ * @param first 첫 점 번호
+ * @param last 마지막 점 다음 번호
+ * @remark 정의되지 않는 점에서 선을 끊고, 픽셀 열마다 점을 줄여 그린다
+ */
+void SeriesRenderer::drawPoints(QPainter *painter, qint64 first, qint64 last)
+{
+    // 그래프와 같은 빨간색
+    painter->setPen(Qt::red);
+
+    QPolygonF segment;
+
+    for (qint64 i = first; i < last; ++i)
+    {
+        double x = _buffer.x(i);
+        float y = _buffer.y(i);
+
+        if (qIsFinite(x) && qIsFinite(y))
+            segment.append(map(x, y));
+        else if (!segment.isEmpty())
+        {
+            painter->drawPolyline(GraphRenderer::decimate(segment, _dpr));
+            segment.clear();
+        }
+    }
+
+    if (!segment.isEmpty())
+        painter->drawPolyline(GraphRenderer::decimate(segment, _dpr));
+}
+
+/**
+ * @brief 범위와 크기로 배율을 계산한다
+ */
+void SeriesRenderer::updateScale()
+{
+    int w = _size.width() - 1;  // 실제로 그릴 수 있는 폭
+    int h = _size.height() - 1; // 실제로 그릴 수 있는 높이
+
+    _xScale = w / (_xMax - _xMin);
+    _yScale = h / (static_cast<double>(_yMax) - _yMin);
+}
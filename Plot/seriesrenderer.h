@@ -0,0 +1,120 @@
+/****************************************************************************
+**
+** seriesrenderer.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef SERIESRENDERER_H
+#define SERIESRENDERER_H
+
+#include "seriesbuffer.h"
+
+#include <QPixmap>
+#include <QPointF>
+#include <QSize>
+
+class QPainter;
+
+/**
+ * @brief 실시간 데이터 렌더러
+ *
+ * 고리 버퍼의 점들을 픽스맵에 그려 두고, 새 점이 들어오면 마지막으로 그린
+ * 점부터 새 점까지만 이어 그린다. 화면에는 픽스맵을 옮겨 그리기만 한다.
+ *
+ * 새 점이 오른쪽 끝을 넘으면, 버퍼가 넘쳐 오래된 점을 버리고 있을 때는
+ * 픽스맵을 왼쪽으로 밀고 드러난 부분에만 그린다. 아직 버퍼가 차지 않았으면
+ * x 범위를 두 배로 넓혀 다시 그린다. y 값이 범위를 벗어나도 여유를 두고
+ * 넓혀 다시 그리므로, 전체를 다시 그리는 일은 드물다.
+ */
+class SeriesRenderer
+{
+public:
+    SeriesRenderer();
+
+    void clear();
+    void setSize(const QSize &size, qreal devicePixelRatio = 1);
+    void append(const double *xs, const float *ys, int n);
+
+    /**
+     * @brief 점들을 가진 고리 버퍼를 돌려준다
+     * @return 고리 버퍼
+     */
+    const SeriesBuffer &buffer() const
+    {
+        return _buffer;
+    }
+
+    /**
+     * @brief 그릴 점이 없는지 알려준다
+     * @return 점이 없으면 true, 아니면 false
+     */
+    bool isEmpty() const
+    {
+        return _buffer.size() == 0;
+    }
+
+    /**
+     * @brief 전체를 다시 그린 횟수를 돌려준다
+     * @return 다시 그린 횟수
+     */
+    int redrawCount() const
+    {
+        return _redrawCount;
+    }
+
+    void paint(QPainter *painter);
+
+private:
+    SeriesBuffer _buffer;   ///< 점들
+    QSize _size;            ///< 논리 픽셀 단위의 크기
+    qreal _dpr;             ///< 장치 픽셀 비율
+
+    QPixmap _pixmap;        ///< 그려 둔 점들
+    bool _pixmapValid;      ///< 픽스맵이 유효한지 여부
+    qint64 _drawn;          ///< 픽스맵에 그린 점 수. 점 번호로 셈
+    int _redrawCount;       ///< 전체를 다시 그린 횟수
+
+    double _xMin;           ///< 픽스맵의 x 최솟값
+    double _xMax;           ///< 픽스맵의 x 최댓값
+    float _yMin;            ///< 픽스맵의 y 최솟값
+    float _yMax;            ///< 픽스맵의 y 최댓값
+    double _xScale;         ///< 수평 배율
+    double _yScale;         ///< 수직 배율
+
+    /**
+     * @brief 점의 논리 픽셀 위치를 구한다
+     * @param x x 값
+     * @param y y 값
+     * @return 픽스맵 안의 위치
+     */
+    QPointF map(double x, float y) const
+    {
+        return QPointF((x - _xMin) * _xScale, (_yMax - y) * _yScale);
+    }
+
+    void redraw();
+    void drawNew();
+    void scroll(double x);
+    void drawAxis(QPainter *painter, qreal left, qreal right);
+    void drawPoints(QPainter *painter, qint64 first, qint64 last);
+    void updateScale();
+};
+
+#endif // SERIESRENDERER_H
@@ -0,0 +1,449 @@
+/****************************************************************************
+**
+** vecmath.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#include "vecmath.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VECMATH_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VECMATH_SSE2
+#endif
+
+namespace {
+
+#if defined(VECMATH_AVX2)
+/**
+ * @brief AVX2 벡터 연산
+ */
+struct Simd
+{
+    typedef __m256 V;   ///< float 벡터
+    typedef __m256i I;  ///< int 벡터
+
+    enum { Width = 8 };
+
+    static inline V load(const float *p) { return _mm256_loadu_ps(p); }
+    static inline void store(float *p, V v) { _mm256_storeu_ps(p, v); }
+    static inline V set1(float f) { return _mm256_set1_ps(f); }
+
+    static inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static inline V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static inline V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static inline V max(V a, V b) { return _mm256_max_ps(a, b); }
+
+    static inline V andV(V a, V b) { return _mm256_and_ps(a, b); }
+    static inline V andNotV(V a, V b) { return _mm256_andnot_ps(a, b); }
+    static inline V orV(V a, V b) { return _mm256_or_ps(a, b); }
+    static inline V xorV(V a, V b) { return _mm256_xor_ps(a, b); }
+
+    static inline V cmpEq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static inline V cmpLt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static inline V cmpLe(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static inline V cmpGt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+
+    /// mask 가 참인 곳은 a, 아니면 b
+    static inline V select(V mask, V a, V b)
+    {
+        return _mm256_blendv_ps(b, a, mask);
+    }
+
+    static inline int moveMask(V v) { return _mm256_movemask_ps(v); }
+
+    static inline I truncate(V v) { return _mm256_cvttps_epi32(v); }
+    static inline V toFloat(I i) { return _mm256_cvtepi32_ps(i); }
+    static inline I asInt(V v) { return _mm256_castps_si256(v); }
+    static inline V asFloat(I i) { return _mm256_castsi256_ps(i); }
+
+    static inline I iset1(int i) { return _mm256_set1_epi32(i); }
+    static inline I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+    static inline I isub(I a, I b) { return _mm256_sub_epi32(a, b); }
+    static inline I iand(I a, I b) { return _mm256_and_si256(a, b); }
+    static inline I ior(I a, I b) { return _mm256_or_si256(a, b); }
+    static inline I shiftLeft23(I i) { return _mm256_slli_epi32(i, 23); }
+    static inline I shiftLeft31(I i) { return _mm256_slli_epi32(i, 31); }
+    static inline I shiftRight23(I i) { return _mm256_srli_epi32(i, 23); }
+};
+#elif defined(VECMATH_SSE2)
+/**
+ * @brief SSE2 벡터 연산
+ */
+struct Simd
+{
+    typedef __m128 V;   ///< float 벡터
+    typedef __m128i I;  ///< int 벡터
+
+    enum { Width = 4 };
+
+    static inline V load(const float *p) { return _mm_loadu_ps(p); }
+    static inline void store(float *p, V v) { _mm_storeu_ps(p, v); }
+    static inline V set1(float f) { return _mm_set1_ps(f); }
+
+    static inline V add(V a, V b) { return _mm_add_ps(a, b); }
+    static inline V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static inline V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static inline V div(V a, V b) { return _mm_div_ps(a, b); }
+    static inline V min(V a, V b) { return _mm_min_ps(a, b); }
+    static inline V max(V a, V b) { return _mm_max_ps(a, b); }
+
+    static inline V andV(V a, V b) { return _mm_and_ps(a, b); }
+    static inline V andNotV(V a, V b) { return _mm_andnot_ps(a, b); }
+    static inline V orV(V a, V b) { return _mm_or_ps(a, b); }
+    static inline V xorV(V a, V b) { return _mm_xor_ps(a, b); }
+
+    static inline V cmpEq(V a, V b) { return _mm_cmpeq_ps(a, b); }
+    static inline V cmpLt(V a, V b) { return _mm_cmplt_ps(a, b); }
+    static inline V cmpLe(V a, V b) { return _mm_cmple_ps(a, b); }
+    static inline V cmpGt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+
+    /// mask 가 참인 곳은 a, 아니면 b
+    static inline V select(V mask, V a, V b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    static inline int moveMask(V v) { return _mm_movemask_ps(v); }
+
+    static inline I truncate(V v) { return _mm_cvttps_epi32(v); }
+    static inline V toFloat(I i) { return _mm_cvtepi32_ps(i); }
+    static inline I asInt(V v) { return _mm_castps_si128(v); }
+    static inline V asFloat(I i) { return _mm_castsi128_ps(i); }
+
+    static inline I iset1(int i) { return _mm_set1_epi32(i); }
+    static inline I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+    static inline I isub(I a, I b) { return _mm_sub_epi32(a, b); }
+    static inline I iand(I a, I b) { return _mm_and_si128(a, b); }
+    static inline I ior(I a, I b) { return _mm_or_si128(a, b); }
+    static inline I shiftLeft23(I i) { return _mm_slli_epi32(i, 23); }
+    static inline I shiftLeft31(I i) { return _mm_slli_epi32(i, 31); }
+    static inline I shiftRight23(I i) { return _mm_srli_epi32(i, 23); }
+};
+#endif
+
+#if defined(VECMATH_AVX2) || defined(VECMATH_SSE2)
+/**
+ * @brief 벡터 거듭제곱을 계산한다
+ * @param a 밑
+ * @param b 지수
+ * @param special 직접 계산해야 하는 자리의 비트 마스크를 돌려받음
+ * @return a^b
+ * @remark 2^(b * log2|a|) 를 다항식 근사로 계산하며, 상대 오차는 약
+ *         1e-5 이하이다. a 가 0, 비정규수, 무한대, NaN 이거나 b 가 무한대,
+ *         NaN 인 자리는 special 에 표시되며, 그 값은 의미가 없다.
+ */
+inline Simd::V powV(Simd::V a, Simd::V b, int *special)
+{
+    typedef Simd S;
+
+    const S::V one = S::set1(1.0f);
+    const S::V signMask = S::asFloat(S::iset1(0x80000000));
+
+    S::V absA = S::andNotV(signMask, a);
+    S::V absB = S::andNotV(signMask, b);
+
+    // 직접 계산해야 하는 자리
+    *special = S::moveMask(
+                S::andNotV(S::andV(S::andV(S::cmpLe(S::set1(FLT_MIN), absA),
+                                           S::cmpLe(absA, S::set1(FLT_MAX))),
+                                   S::cmpLe(absB, S::set1(FLT_MAX))),
+                           S::asFloat(S::iset1(-1))));
+
+    // |a| = m * 2^e, m 은 [sqrt(1/2), sqrt(2)) 범위로 맞춤
+    S::I bits = S::asInt(absA);
+    S::V e = S::toFloat(S::isub(S::shiftRight23(bits), S::iset1(127)));
+    S::V m = S::asFloat(S::ior(S::iand(bits, S::iset1(0x007fffff)),
+                               S::iset1(0x3f800000)));
+    S::V big = S::cmpGt(m, S::set1(1.41421356f));
+
+    m = S::select(big, S::mul(m, S::set1(0.5f)), m);
+    e = S::add(e, S::andV(big, one));
+
+    // ln(m) 은 x = m - 1 에 대한 다항식으로 근사 (Cephes logf)
+    S::V x = S::sub(m, one);
+    S::V z = S::mul(x, x);
+    S::V p = S::set1(7.0376836292e-2f);
+
+    p = S::add(S::mul(p, x), S::set1(-1.1514610310e-1f));
+    p = S::add(S::mul(p, x), S::set1(1.1676998740e-1f));
+    p = S::add(S::mul(p, x), S::set1(-1.2420140846e-1f));
+    p = S::add(S::mul(p, x), S::set1(1.4249322787e-1f));
+    p = S::add(S::mul(p, x), S::set1(-1.6668057665e-1f));
+    p = S::add(S::mul(p, x), S::set1(2.0000714765e-1f));
+    p = S::add(S::mul(p, x), S::set1(-2.4999993993e-1f));
+    p = S::add(S::mul(p, x), S::set1(3.3333331174e-1f));
+
+    S::V lnM = S::add(x, S::sub(S::mul(S::mul(p, x), z),
+                                S::mul(S::set1(0.5f), z)));
+
+    // log2|a| = e + ln(m) / ln(2)
+    S::V log2A = S::add(e, S::mul(S::set1(1.44269504f), lnM));
+
+    // 2^y, y = n + f, n 은 정수, f 는 [0, 1)
+    S::V y = S::mul(b, log2A);
+    S::V yc = S::min(S::max(y, S::set1(-126.0f)), S::set1(127.99998f));
+    S::V n = S::toFloat(S::truncate(yc));
+
+    n = S::sub(n, S::andV(S::cmpGt(n, yc), one));  // 음수 내림 보정
+
+    // 2^f = sqrt(2) * e^((f - 1/2) * ln(2))
+    S::V g = S::mul(S::sub(S::sub(yc, n), S::set1(0.5f)),
+                    S::set1(0.693147181f));
+    S::V q = S::set1(1.0f / 5040);
+
+    q = S::add(S::mul(q, g), S::set1(1.0f / 720));
+    q = S::add(S::mul(q, g), S::set1(1.0f / 120));
+    q = S::add(S::mul(q, g), S::set1(1.0f / 24));
+    q = S::add(S::mul(q, g), S::set1(1.0f / 6));
+    q = S::add(S::mul(q, g), S::set1(0.5f));
+    q = S::add(S::mul(q, g), one);
+    q = S::add(S::mul(q, g), one);
+
+    S::V scale = S::asFloat(S::shiftLeft23(S::iadd(S::truncate(n),
+                                                   S::iset1(127))));
+    S::V r = S::mul(S::mul(q, S::set1(1.41421356f)), scale);
+
+    // 넘침과 아래넘침
+    r = S::select(S::cmpLt(y, S::set1(128.0f)), r,
+                  S::set1(std::numeric_limits<float>::infinity()));
+    r = S::select(S::cmpLt(y, S::set1(-126.0f)), S::set1(0.0f), r);
+
+    // b 가 0 이면 1
+    r = S::select(S::cmpEq(b, S::set1(0.0f)), one, r);
+
+    S::V negA = S::cmpLt(a, S::set1(0.0f));
+
+    if (!S::moveMask(negA))
+        return r;
+
+    // 음수 밑은 b 가 정수일 때만 정의됨. 홀수이면 음수
+    S::I bi = S::truncate(b);
+    S::V huge = S::cmpLe(S::set1(16777216.0f), absB);  // 2^24 이상은 짝수
+    S::V isInt = S::andV(S::cmpEq(S::toFloat(bi), b), S::cmpEq(b, b));
+    S::V oddSign = S::andNotV(huge, S::asFloat(S::shiftLeft31(bi)));
+    S::V negR = S::select(S::orV(huge, isInt), S::xorV(r, oddSign),
+                          S::set1(std::numeric_limits<float>::quiet_NaN()));
+
+    return S::select(negA, negR, r);
+}
+#endif
+
+} // namespace
+
+namespace VecMath {
+
+/**
+ * @brief 사용 중인 명령어 집합의 이름을 돌려준다
+ * @return 명령어 집합 이름
+ */
+const char *instructionSet()
+{
+#if defined(VECMATH_AVX2)
+    return "AVX2";
+#elif defined(VECMATH_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * @brief 배열을 한 값으로 채운다
+ * @param dst 채울 배열
+ * @param value 채울 값
+ * @param n 개수
+ */
+void fill(float *dst, float value, int n)
+{
+    int i = 0;
+
+#if defined(VECMATH_AVX2) || defined(VECMATH_SSE2)
+    Simd::V v = Simd::set1(value);
+
+    for (; i + Simd::Width <= n; i += Simd::Width)
+        Simd::store(dst + i, v);
+#endif
+
+    for (; i < n; ++i)
+        dst[i] = value;
+}
+
+/**
+ * @brief 배열을 복사한다
+ * @param dst 대상 배열
+ * @param src 원본 배열
+ * @param n 개수
+ */
+void copy(float *dst, const float *src, int n)
+{
+    memcpy(dst, src, n * sizeof(float));
+}
+
+/// a[i] = a[i] OP b[i] 를 계산하는 함수를 정의한다
+#if defined(VECMATH_AVX2) || defined(VECMATH_SSE2)
+#define VECMATH_BINARY(name, op) \
+    void name(float *a, const float *b, int n) \
+    { \
+        int i = 0; \
+        for (; i + Simd::Width <= n; i += Simd::Width) \
+            Simd::store(a + i, Simd::name(Simd::load(a + i), \
+                                          Simd::load(b + i))); \
+        for (; i < n; ++i) \
+            a[i] op##= b[i]; \
+    }
+#else
+#define VECMATH_BINARY(name, op) \
+    void name(float *a, const float *b, int n) \
+    { \
+        for (int i = 0; i < n; ++i) \
+            a[i] op##= b[i]; \
+    }
+#endif
+
+VECMATH_BINARY(add, +)
+VECMATH_BINARY(sub, -)
+VECMATH_BINARY(mul, *)
+VECMATH_BINARY(div, /)
+
+#undef VECMATH_BINARY
+
+/**
+ * @brief 배열의 부호를 바꾼다
+ * @param a 배열
+ * @param n 개수
+ */
+void neg(float *a, int n)
+{
+    int i = 0;
+
+#if defined(VECMATH_AVX2) || defined(VECMATH_SSE2)
+    Simd::V signMask = Simd::asFloat(Simd::iset1(0x80000000));
+
+    for (; i + Simd::Width <= n; i += Simd::Width)
+        Simd::store(a + i, Simd::xorV(Simd::load(a + i), signMask));
+#endif
+
+    for (; i < n; ++i)
+        a[i] = -a[i];
+}
+
+/**
+ * @brief 배열의 거듭제곱, a[i] = a[i]^b[i] 를 계산한다
+ * @param a 밑 배열. 결과가 저장됨
+ * @param b 지수 배열
+ * @param n 개수
+ */
+void pow(float *a, const float *b, int n)
+{
+    int i = 0;
+
+#if defined(VECMATH_AVX2) || defined(VECMATH_SSE2)
+    for (; i + Simd::Width <= n; i += Simd::Width)
+    {
+        int special;
+        Simd::V r = powV(Simd::load(a + i), Simd::load(b + i), &special);
+
+        if (special)
+        {
+            // 특수한 값은 직접 계산
+            float res[Simd::Width];
+
+            Simd::store(res, r);
+
+            for (int k = 0; k < Simd::Width; ++k)
+            {
+                if (special & (1 << k))
+                    res[k] = std::pow(a[i + k], b[i + k]);
+            }
+
+            memcpy(a + i, res, sizeof(res));
+        }
+        else
+            Simd::store(a + i, r);
+    }
+#endif
+
+    for (; i < n; ++i)
+        a[i] = std::pow(a[i], b[i]);
+}
+
+/**
+ * @brief 배열의 정수 거듭제곱, a[i] = a[i]^exponent 를 계산한다
+ * @param a 밑 배열. 결과가 저장됨
+ * @param exponent 정수 지수
+ * @param n 개수
+ * @remark 제곱을 거듭하며 곱하므로 pow() 보다 빠르다. 1 에 곱하는 것부터
+ *         시작하므로, 곱하는 순서는 PolyJit 의 기계어와 같다.
+ */
+void powInt(float *a, int exponent, int n)
+{
+    unsigned e = exponent < 0 ? 0u - exponent : exponent;
+    int i = 0;
+
+#if defined(VECMATH_AVX2) || defined(VECMATH_SSE2)
+    Simd::V one = Simd::set1(1);
+
+    for (; i + Simd::Width <= n; i += Simd::Width)
+    {
+        Simd::V base = Simd::load(a + i);
+        Simd::V r = one;
+
+        for (unsigned k = e; k; k >>= 1)
+        {
+            if (k & 1)
+                r = Simd::mul(r, base);
+
+            if (k > 1)
+                base = Simd::mul(base, base);
+        }
+
+        Simd::store(a + i, exponent < 0 ? Simd::div(one, r) : r);
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        float base = a[i];
+        float r = 1;
+
+        for (unsigned k = e; k; k >>= 1)
+        {
+            if (k & 1)
+                r *= base;
+
+            if (k > 1)
+                base *= base;
+        }
+
+        a[i] = exponent < 0 ? 1 / r : r;
+    }
+}
+
+} // namespace VecMath
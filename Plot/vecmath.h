@@ -0,0 +1,48 @@
+/****************************************************************************
+**
+** vecmath.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of Plot.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef VECMATH_H
+#define VECMATH_H
+
+/**
+ * @brief float 배열 연산 함수 모음
+ *
+ * AVX2 로 컴파일되면 AVX2 를, SSE2 를 쓸 수 있으면 SSE2 를 사용하고,
+ * 둘 다 안 되면 일반 반복문으로 계산한다.
+ */
+namespace VecMath {
+
+const char *instructionSet();
+
+void fill(float *dst, float value, int n);
+void copy(float *dst, const float *src, int n);
+void add(float *a, const float *b, int n);
+void sub(float *a, const float *b, int n);
+void mul(float *a, const float *b, int n);
+void div(float *a, const float *b, int n);
+void neg(float *a, int n);
+void pow(float *a, const float *b, int n);
+void powInt(float *a, int exponent, int n);
+
+} // namespace VecMath
+
+#endif // VECMATH_H
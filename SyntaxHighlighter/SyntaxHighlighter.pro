@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -13,6 +13,36 @@ TEMPLATE = app
 
 
 SOURCES += main.cpp\
-        mainwindow.cpp
+        mainwindow.cpp \
+        grammar.cpp \
+        highlighter.cpp \
+        highlightercli.cpp \
+        htmlwriter.cpp \
+        legacyhighlighter.cpp \
+        memorystats.cpp \
+        parallellexer.cpp \
+        tokenlexer.cpp \
+        tokenmatcher.cpp
 
-HEADERS  += mainwindow.h
+HEADERS  += mainwindow.h \
+        grammar.h \
+        highlighter.h \
+        highlightercli.h \
+        htmlwriter.h \
+        legacyhighlighter.h \
+        memorystats.h \
+        parallellexer.h \
+        tokenlexer.h \
+        tokenmatcher.h \
+        tokenparser.h
+
+# 성능을 잴 때 할당 횟수도 세려면 "qmake CONFIG+=allocation_stats" 로
+# 빌드한다. glibc 의 malloc() 을 가로채므로, 평소 빌드나 새니타이저,
+# LD_PRELOAD 로 바꾼 할당자와는 함께 쓰지 않는다.
+allocation_stats: DEFINES += SH_COUNT_ALLOCATIONS
+
+RESOURCES += languages.qrc
+
+DISTFILES += languages/cpp.lang \
+        languages/python.lang \
+        languages/sql.lang
@@ -0,0 +1,667 @@
+/****************************************************************************
+**
+** grammar.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+
+/** @file grammar.cpp
+ */
+
+#include "grammar.h"
+#include "tokenmatcher.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief 컴파일하는 동안 표들을 모음
+ */
+struct Builder
+{
+    QVector<ushort> strings;            /// 문자열 풀
+    QVector<Grammar::Node> nodes;       /// 트라이 노드들
+    qint32 roots[128];                  /// ASCII 문자마다 첫 노드
+    QVector<Grammar::Block> blocks;     /// 블럭들
+
+    Builder()
+    {
+        for (int i = 0; i < 128; ++i)
+            roots[i] = -1;
+    }
+
+    /**
+     * @brief 문자열을 풀에 추가
+     * @param s 문자열
+     * @return 풀에서 센 위치
+     */
+    quint32 addString(const QString &s)
+    {
+        quint32 offset = strings.size();
+
+        for (int i = 0; i < s.length(); ++i)
+            strings.append(s.at(i).unicode());
+
+        return offset;
+    }
+
+    /**
+     * @brief 기호를 트라이에 추가
+     * @param symbol 기호. ASCII 문자로 시작해야 함
+     * @param kind 토큰 종류
+     * @param block 시작하는 블럭 번호. 블럭이 아니면 -1
+     */
+    void addSymbol(const QString &symbol, int kind, int block)
+    {
+        int node = -1;
+
+        for (int i = 0; i < symbol.length(); ++i)
+        {
+            ushort ch = symbol.at(i).unicode();
+
+            // 같은 문자의 자식 노드 찾음. 첫 문자는 ASCII 표에서 찾음
+            int child = node < 0 ? roots[ch] : nodes.at(node).child;
+            int last = -1;
+
+            while (child >= 0 && nodes.at(child).ch != ch)
+            {
+                last = child;
+                child = nodes.at(child).sibling;
+            }
+
+            // 없으면 추가
+            if (child < 0)
+            {
+                Grammar::Node newNode = {ch, TokenMatcher::None, -1, -1, -1};
+
+                nodes.append(newNode);
+                child = nodes.size() - 1;
+
+                if (last >= 0)
+                    nodes[last].sibling = child;
+                else if (node >= 0)
+                    nodes[node].child = child;
+                else
+                    roots[ch] = child;
+            }
+
+            node = child;
+        }
+
+        nodes[node].kind = kind;
+        nodes[node].block = block;
+    }
+
+    /**
+     * @brief 낱말들의 해시 표를 만듦
+     * @param words 낱말들
+     * @param fold true 이면 대소문자를 가리지 않음
+     * @return 열린 주소법 해시 표. 크기는 낱말 수의 두 배 이상인 2 의
+     *         거듭제곱
+     */
+    QVector<Grammar::Slot> hashTable(const QStringList &words, bool fold)
+    {
+        int size = 2;
+
+        while (size < words.size() * 2)
+            size *= 2;
+
+        Grammar::Slot empty = {0, 0, 0};
+        QVector<Grammar::Slot> table(size, empty);
+
+        foreach (QString word, words)
+        {
+            // 찾을 때처럼 ASCII 대문자만 소문자로 바꿈
+            for (int i = 0; fold && i < word.length(); ++i)
+            {
+                if (word.at(i) >= 'A' && word.at(i) <= 'Z')
+                    word[i] = QChar(word.at(i).unicode() + ('a' - 'A'));
+            }
+
+            quint32 h = Grammar::hash(word);
+            int i = h & (size - 1);
+
+            // 같은 낱말이 이미 있으면 넘어감
+            for (; table.at(i).length > 0; i = (i + 1) & (size - 1))
+            {
+                const Grammar::Slot &slot = table.at(i);
+
+                if (slot.hash == h && int(slot.length) == word.length()
+                        && std::memcmp(strings.constData() + slot.offset,
+                                       word.unicode(),
+                                       word.length() * sizeof(ushort)) == 0)
+                    break;
+            }
+
+            if (table.at(i).length == 0)
+            {
+                Grammar::Slot slot = {h, addString(word),
+                                      quint32(word.length())};
+
+                table[i] = slot;
+            }
+        }
+
+        return table;
+    }
+};
+
+/**
+ * @brief 예, 아니오 값을 읽음
+ * @param value 값
+ * @param ok 올바른 값이면 true 를 돌려받음
+ * @return yes 나 true 이면 true
+ */
+bool toBool(const QString &value, bool *ok)
+{
+    *ok = true;
+
+    if (value == "yes" || value == "true")
+        return true;
+
+    if (value == "no" || value == "false")
+        return false;
+
+    *ok = false;
+
+    return false;
+}
+
+/**
+ * @brief 표를 이미지 끝에 붙임
+ * @param image 이미지
+ * @param data 표
+ * @param size 표의 바이트 수
+ * @return 이미지 시작에서 센 표의 위치
+ * @remark 표는 4 바이트 경계에 맞춤
+ */
+quint32 appendTable(QByteArray *image, const void *data, int size)
+{
+    while (image->size() % 4 != 0)
+        image->append('\0');
+
+    quint32 offset = image->size();
+
+    image->append(static_cast<const char *>(data), size);
+
+    return offset;
+}
+
+} // namespace
+
+/**
+ * @brief Grammar 생성자
+ */
+Grammar::Grammar()
+    : _data(0)
+{
+}
+
+/**
+ * @brief 언어 정의를 이미지로 컴파일함
+ * @param definition 정의 파일의 내용. UTF-8
+ * @param error 실패하면 이유를 돌려받음. 0 이면 돌려받지 않음
+ * @return 이미지. 실패하면 빈 배열
+ */
+QByteArray Grammar::compile(const QByteArray &definition, QString *error)
+{
+    static const struct
+    {
+        const char *key;
+        TokenMatcher::Kind kind;
+    } blockKeys[] = {
+        {"string", TokenMatcher::String},
+        {"char", TokenMatcher::Char},
+        {"comment", TokenMatcher::Comment},
+        {"line-comment", TokenMatcher::LineComment}
+    };
+
+    static const char *const listKeys[] = {
+        "name", "extensions", "case-sensitive", "escape",
+        "line-continuation", "keywords", "directive-prefix", "directives",
+        "operators"
+    };
+
+    QHash<QString, QStringList> values;
+    QStringList blockStarts;
+    QStringList blockEnds;
+    QVector<TokenMatcher::Kind> blockKinds;
+
+    const QStringList lines = QString::fromUtf8(definition).split('\n');
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        QString line = lines.at(i).trimmed();
+
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        int eq = line.indexOf('=');
+        QString key = line.left(qMax(eq, 0)).trimmed();
+        QString value = line.mid(eq + 1).simplified();
+
+        // simplified() 가 공백을 하나로 줄이므로, 값이 비어 있을 때만 빈
+        // 토큰이 생김
+        QStringList tokens = value.isEmpty() ? QStringList()
+                                             : value.split(' ');
+
+        if (eq < 0 || key.isEmpty())
+        {
+            if (error)
+                *error = QObject::tr("%1 번째 줄: '키 = 값' 형식이 아님")
+                            .arg(i + 1);
+
+            return QByteArray();
+        }
+
+        // 블럭은 나올 때마다 하나씩 추가
+        bool isBlock = false;
+
+        for (size_t b = 0; b < sizeof(blockKeys) / sizeof(blockKeys[0]); ++b)
+        {
+            if (key != blockKeys[b].key)
+                continue;
+
+            if (tokens.isEmpty() || tokens.size() > 2)
+            {
+                if (error)
+                    *error = QObject::tr("%1 번째 줄: 블럭은 시작 토큰과 "
+                                         "끝 토큰이어야 함").arg(i + 1);
+
+                return QByteArray();
+            }
+
+            blockStarts.append(tokens.at(0));
+            blockEnds.append(tokens.value(1));
+            blockKinds.append(blockKeys[b].kind);
+
+            isBlock = true;
+        }
+
+        if (isBlock)
+            continue;
+
+        bool known = false;
+
+        for (size_t k = 0; k < sizeof(listKeys) / sizeof(listKeys[0]); ++k)
+            known = known || key == listKeys[k];
+
+        if (!known)
+        {
+            if (error)
+                *error = QObject::tr("%1 번째 줄: 알 수 없는 키 %2")
+                            .arg(i + 1).arg(key);
+
+            return QByteArray();
+        }
+
+        values[key] += tokens;
+    }
+
+    // 한 값만 갖는 키들
+    const QString name = values.value("name").join(' ');
+    const QStringList escape = values.value("escape");
+    const QStringList prefix = values.value("directive-prefix");
+
+    bool caseSensitive = true;
+    bool lineContinuation = false;
+    bool ok = true;
+
+    if (values.contains("case-sensitive"))
+        caseSensitive = toBool(values.value("case-sensitive").join(' '), &ok);
+
+    if (ok && values.contains("line-continuation"))
+        lineContinuation = toBool(values.value("line-continuation").join(' '),
+                                  &ok);
+
+    if (!ok)
+    {
+        if (error)
+            *error = QObject::tr("case-sensitive 와 line-continuation 은 "
+                                 "yes 나 no 이어야 함");
+
+        return QByteArray();
+    }
+
+    if (name.isEmpty())
+    {
+        if (error)
+            *error = QObject::tr("언어 이름(name)이 없음");
+
+        return QByteArray();
+    }
+
+    if (escape.size() > 1
+            || (escape.size() == 1 && (escape.at(0).length() != 1
+                                       || escape.at(0).at(0).unicode() >= 128)))
+    {
+        if (error)
+            *error = QObject::tr("탈출 문자(escape)는 ASCII 문자 하나이어야 함");
+
+        return QByteArray();
+    }
+
+    if (prefix.size() > 1)
+    {
+        if (error)
+            *error = QObject::tr("지시자 접두어(directive-prefix)는 하나이어야 "
+                                 "함");
+
+        return QByteArray();
+    }
+
+    if (blockStarts.size() > MaxBlocks)
+    {
+        if (error)
+            *error = QObject::tr("블럭은 %1 개까지만 정의할 수 있음")
+                        .arg(int(MaxBlocks));
+
+        return QByteArray();
+    }
+
+    // 기호는 모두 ASCII 문자로 시작해야 함
+    const QStringList operators = values.value("operators");
+    QStringList symbols = operators + blockStarts + prefix;
+
+    foreach (const QString &symbol, symbols)
+    {
+        if (symbol.at(0).unicode() >= 128)
+        {
+            if (error)
+                *error = QObject::tr("ASCII 문자로 시작하지 않는 기호: %1")
+                            .arg(symbol);
+
+            return QByteArray();
+        }
+    }
+
+    // 표 생성. 블럭 시작과 지시자 접두어는 같은 기호보다 우선
+    Builder builder;
+
+    foreach (const QString &op, operators)
+        builder.addSymbol(op, TokenMatcher::Operator, -1);
+
+    for (int i = 0; i < blockStarts.size(); ++i)
+    {
+        builder.addSymbol(blockStarts.at(i), blockKinds.at(i), i);
+
+        Block block = {quint32(blockKinds.at(i)),
+                       builder.addString(blockEnds.at(i)),
+                       quint32(blockEnds.at(i).length())};
+
+        builder.blocks.append(block);
+    }
+
+    if (!prefix.isEmpty())
+        builder.addSymbol(prefix.at(0), TokenMatcher::DirectivePrefix, -1);
+
+    QVector<Slot> keywords = builder.hashTable(values.value("keywords"),
+                                               !caseSensitive);
+    QVector<Slot> directives = builder.hashTable(values.value("directives"),
+                                                 !caseSensitive);
+
+    Header header;
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "SHGRAMMR", sizeof(header.magic));
+
+    header.byteOrder = ByteOrderMark;
+    header.version = FormatVersion;
+
+    QByteArray digest = QCryptographicHash::hash(definition,
+                                                 QCryptographicHash::Md5);
+
+    std::memcpy(header.digest, digest.constData(), sizeof(header.digest));
+
+    header.flags = (caseSensitive ? CaseSensitive : 0)
+                    | (lineContinuation ? LineContinuation : 0);
+    header.escapeChar = escape.isEmpty() ? -1 : escape.at(0).at(0).unicode();
+    header.nameOffset = builder.addString(name);
+    header.nameLength = name.length();
+
+    // ASCII 문자 종류 표
+    uchar classes[128];
+
+    for (int i = 0; i < 128; ++i)
+    {
+        QChar ch(i);
+
+        if (ch.isLetterOrNumber() || ch == '_')
+            classes[i] = TokenMatcher::WordChar;
+        else if (i == header.escapeChar)
+            classes[i] = TokenMatcher::EscapeChar;
+        else if (builder.roots[i] >= 0)
+            classes[i] = TokenMatcher::SymbolChar;
+        else
+            classes[i] = TokenMatcher::OtherChar;
+    }
+
+    // 머리 다음에 표들을 붙이고, 위치가 정해지면 머리를 다시 씀
+    QByteArray image(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    header.classesOffset = appendTable(&image, classes, sizeof(classes));
+    header.rootsOffset = appendTable(&image, builder.roots,
+                                     sizeof(builder.roots));
+    header.nodesOffset = appendTable(&image, builder.nodes.constData(),
+                                     builder.nodes.size() * sizeof(Node));
+    header.nodeCount = builder.nodes.size();
+    header.keywordsOffset = appendTable(&image, keywords.constData(),
+                                        keywords.size() * sizeof(Slot));
+    header.keywordSlots = keywords.size();
+    header.directivesOffset = appendTable(&image, directives.constData(),
+                                          directives.size() * sizeof(Slot));
+    header.directiveSlots = directives.size();
+    header.blocksOffset = appendTable(&image, builder.blocks.constData(),
+                                      builder.blocks.size() * sizeof(Block));
+    header.blockCount = builder.blocks.size();
+    header.stringsOffset = appendTable(&image, builder.strings.constData(),
+                                       builder.strings.size()
+                                       * sizeof(ushort));
+    header.stringsLength = builder.strings.size();
+    header.size = image.size();
+
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    return image;
+}
+
+/**
+ * @brief 언어 정의를 불러옴
+ * @param fileName 정의 파일
+ * @param error 실패하면 이유를 돌려받음. 0 이면 돌려받지 않음
+ * @return 언어 정의. 실패하면 0
+ * @remark 캐시가 정의 파일과 같으면 캐시를 사상하고, 아니면 컴파일하여
+ *         캐시에 저장함. 캐시를 저장하지 못해도 컴파일한 이미지를 씀
+ */
+QSharedPointer<const Grammar> Grammar::load(const QString &fileName,
+                                            QString *error)
+{
+    QFile source(fileName);
+
+    if (!source.open(QIODevice::ReadOnly))
+    {
+        if (error)
+            *error = source.errorString();
+
+        return QSharedPointer<const Grammar>();
+    }
+
+    const QByteArray definition = source.readAll();
+    const QByteArray digest = QCryptographicHash::hash(definition,
+                                                       QCryptographicHash::Md5);
+    const QString cacheName = cacheFileName(fileName);
+
+    QSharedPointer<Grammar> grammar(new Grammar);
+
+    // 캐시가 정의 파일과 같으면 사상하여 씀
+    grammar->_file.setFileName(cacheName);
+
+    if (grammar->_file.open(QIODevice::ReadOnly))
+    {
+        qint64 size = grammar->_file.size();
+        const uchar *data = grammar->_file.map(0, size);
+
+        if (data && isValid(data, size, digest))
+        {
+            grammar->_data = data;
+
+            return grammar;
+        }
+
+        grammar->_file.close();
+    }
+
+    // 컴파일하여 캐시에 저장
+    QString compileError;
+
+    grammar->_image = compile(definition, &compileError);
+
+    if (grammar->_image.isEmpty())
+    {
+        if (error)
+            *error = fileName + ": " + compileError;
+
+        return QSharedPointer<const Grammar>();
+    }
+
+    grammar->_data = reinterpret_cast<const uchar *>(
+                        grammar->_image.constData());
+
+    // 새 파일에 쓰고 이름을 바꾸므로, 다른 프로세스가 사상한 옛 캐시는
+    // 그대로 남음
+    QSaveFile cache(cacheName);
+
+    if (QDir().mkpath(QFileInfo(cacheName).absolutePath())
+            && cache.open(QIODevice::WriteOnly))
+    {
+        cache.write(grammar->_image);
+        cache.commit();
+    }
+
+    return grammar;
+}
+
+/**
+ * @brief 기본 언어인 C/C++ 정의를 얻음
+ * @return 언어 정의. 처음 부를 때 한 번만 불러옴
+ * @remark 리소스의 정의가 없거나 잘못되었으면 아무것도 칠하지 않는 빈
+ *         정의를 돌려줌
+ */
+QSharedPointer<const Grammar> Grammar::builtin()
+{
+    static const QSharedPointer<const Grammar> grammar =
+            []() -> QSharedPointer<const Grammar>
+    {
+        QSharedPointer<const Grammar> cpp = load(":/languages/cpp.lang");
+
+        if (!cpp.isNull())
+            return cpp;
+
+        QSharedPointer<Grammar> plain(new Grammar);
+
+        plain->_image = compile("name = Plain");
+        plain->_data = reinterpret_cast<const uchar *>(
+                            plain->_image.constData());
+
+        return plain;
+    }();
+
+    return grammar;
+}
+
+/**
+ * @brief 쓸 수 있는 언어 정의 파일들을 얻음
+ * @return 리소스의 정의 파일들과, 실행 파일 옆 languages 디렉토리의 정의
+ *         파일들. 이름이 같으면 languages 디렉토리의 파일이 우선
+ */
+QStringList Grammar::definitionFiles()
+{
+    QStringList files;
+    QStringList names;
+
+    QDir local(QCoreApplication::applicationDirPath() + "/languages");
+    QDir resource(":/languages");
+
+    foreach (const QDir &dir, QList<QDir>() << local << resource)
+    {
+        foreach (const QFileInfo &info,
+                 dir.entryInfoList(QStringList("*.lang"), QDir::Files,
+                                   QDir::Name))
+        {
+            if (names.contains(info.fileName()))
+                continue;
+
+            names.append(info.fileName());
+            files.append(info.filePath());
+        }
+    }
+
+    return files;
+}
+
+/**
+ * @brief 정의 파일의 캐시 파일 이름을 얻음
+ * @param fileName 정의 파일
+ * @return 캐시 디렉토리의 파일 이름. 정의 파일의 경로마다 다름
+ */
+QString Grammar::cacheFileName(const QString &fileName)
+{
+    QFileInfo info(fileName);
+
+    // 경로의 해시를 붙여 이름이 같은 다른 정의와 구분
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + "/languages/" + info.completeBaseName() + '-'
+            + QString::number(hash(info.absoluteFilePath()), 16)
+            + ".shlc";
+}
+
+/**
+ * @brief 캐시 이미지를 쓸 수 있는지 확인
+ * @param data 이미지
+ * @param size 이미지 크기
+ * @param digest 정의 파일의 MD5
+ * @return 형식 판, 바이트 순서, 크기, MD5 가 모두 같으면 true
+ */
+bool Grammar::isValid(const uchar *data, qint64 size,
+                      const QByteArray &digest)
+{
+    if (size < qint64(sizeof(Header)))
+        return false;
+
+    const Header *header = reinterpret_cast<const Header *>(data);
+
+    return std::memcmp(header->magic, "SHGRAMMR", sizeof(header->magic)) == 0
+            && header->byteOrder == ByteOrderMark
+            && header->version == FormatVersion
+            && header->size == size
+            && std::memcmp(header->digest, digest.constData(),
+                           sizeof(header->digest)) == 0;
+}
@@ -0,0 +1,244 @@
+/****************************************************************************
+**
+** grammar.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+
+/** @file grammar.h
+ */
+
+#ifndef GRAMMAR_H
+#define GRAMMAR_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+/**
+ * @brief 언어 정의 클래스
+ *
+ * 언어마다 키워드, 지시자, 기호, 블럭을 텍스트 정의 파일로 가진다. 정의는
+ * 한 번만 컴파일하여 포인터 없는 표들의 이미지로 만들고, 캐시 디렉토리에
+ * 저장한다. 다음부터는 캐시 파일을 메모리에 사상하여 표를 그대로 쓰므로,
+ * 정의를 다시 읽거나 표를 만들지 않는다.
+ *
+ * 캐시는 형식 판, 바이트 순서, 크기, 정의 파일의 MD5 가 모두 같을 때만
+ * 쓰고, 하나라도 다르면 다시 컴파일하여 덮어쓴다.
+ *
+ * 정의 파일은 "키 = 값" 줄들이고, 값은 공백으로 나눈 토큰들이다. # 으로
+ * 시작하는 줄은 주석이고, 같은 키가 여러 번 나오면 값을 이어 붙인다.
+ *
+ * @li name : 언어 이름
+ * @li extensions : 파일 확장자들
+ * @li case-sensitive : yes 또는 no. no 이면 키워드와 지시자의 대소문자를
+ *     가리지 않음
+ * @li escape : 탈출 문자. 비어 있으면 없음
+ * @li line-continuation : yes 또는 no. yes 이면 줄 끝의 탈출 문자로 줄
+ *     끝에서 끝나는 블럭이 다음 줄로 이어짐
+ * @li keywords : 키워드들
+ * @li directive-prefix : 지시자 접두어
+ * @li directives : 지시자 접두어 다음에 오는 지시자들
+ * @li operators : 기호들
+ * @li string, char, comment, line-comment : 시작 토큰과 끝 토큰. 끝
+ *     토큰이 없으면 줄 끝에서 끝남. 키가 나올 때마다 블럭이 하나씩 추가됨
+ *
+ * 이미지는 만들어진 뒤 바뀌지 않으므로 여러 스레드에서 함께 쓸 수 있다.
+ */
+class Grammar
+{
+public:
+    enum
+    {
+        FormatVersion = 1,  /// 이미지 형식 판
+        MaxBlocks = 15,     /// 블럭의 최대 수
+        ByteOrderMark = 0x01020304  /// 바이트 순서 확인 값
+    };
+
+    /**
+     * @brief 언어 설정
+     */
+    enum Flag
+    {
+        CaseSensitive = 0x01,       /// 대소문자 구분
+        LineContinuation = 0x02     /// 줄 끝의 탈출 문자로 블럭이 이어짐
+    };
+
+    /**
+     * @brief 이미지 머리. 위치는 모두 이미지 시작에서 센 바이트 수
+     */
+    struct Header
+    {
+        char magic[8];          /// "SHGRAMMR"
+        quint32 byteOrder;      /// ByteOrderMark
+        quint32 version;        /// FormatVersion
+        quint32 size;           /// 이미지 크기
+        uchar digest[16];       /// 정의 파일의 MD5
+        quint32 flags;          /// Flag 조합
+        qint32 escapeChar;      /// 탈출 문자. 없으면 -1
+        quint32 nameOffset;     /// 언어 이름 위치. 문자열 풀에서 센 문자 수
+        quint32 nameLength;     /// 언어 이름 길이
+        quint32 classesOffset;  /// ASCII 문자 종류 표 위치. uchar[128]
+        quint32 rootsOffset;    /// ASCII 문자마다 첫 트라이 노드 위치.
+                                /// qint32[128]
+        quint32 nodesOffset;    /// 트라이 노드 위치
+        quint32 nodeCount;      /// 트라이 노드 수
+        quint32 keywordsOffset; /// 키워드 해시 표 위치
+        quint32 keywordSlots;   /// 키워드 해시 표 크기. 2 의 거듭제곱
+        quint32 directivesOffset;   /// 지시자 해시 표 위치
+        quint32 directiveSlots;     /// 지시자 해시 표 크기. 2 의 거듭제곱
+        quint32 blocksOffset;   /// 블럭 위치
+        quint32 blockCount;     /// 블럭 수
+        quint32 stringsOffset;  /// 문자열 풀 위치. UTF-16
+        quint32 stringsLength;  /// 문자열 풀의 문자 수
+    };
+
+    /**
+     * @brief 트라이 노드
+     */
+    struct Node
+    {
+        quint16 ch;         /// 문자
+        quint16 kind;       /// 여기서 끝나는 토큰의 종류
+        qint32 child;       /// 첫 자식 노드. 없으면 -1
+        qint32 sibling;     /// 다음 형제 노드. 없으면 -1
+        qint32 block;       /// 여기서 시작하는 블럭 번호. 없으면 -1
+    };
+
+    /**
+     * @brief 해시 표 칸. 열린 주소법으로 찾음
+     */
+    struct Slot
+    {
+        quint32 hash;       /// 낱말의 해시
+        quint32 offset;     /// 낱말 위치. 문자열 풀에서 센 문자 수
+        quint32 length;     /// 낱말 길이. 0 이면 빈 칸
+    };
+
+    /**
+     * @brief 블럭
+     */
+    struct Block
+    {
+        quint32 kind;       /// 시작 토큰의 종류
+        quint32 endOffset;  /// 끝 토큰 위치. 문자열 풀에서 센 문자 수
+        quint32 endLength;  /// 끝 토큰 길이. 0 이면 줄 끝에서 끝남
+    };
+
+    static QByteArray compile(const QByteArray &definition,
+                              QString *error = 0);
+
+    static QSharedPointer<const Grammar> load(const QString &fileName,
+                                              QString *error = 0);
+    static QSharedPointer<const Grammar> builtin();
+
+    static QStringList definitionFiles();
+    static QString cacheFileName(const QString &fileName);
+
+    /**
+     * @brief 낱말의 해시를 얻음
+     * @param word 낱말
+     * @param fold true 이면 ASCII 대문자를 소문자로 바꾸어 계산
+     * @return FNV-1a 해시
+     * @remark 캐시에 저장하므로 실행할 때마다 씨앗이 바뀌는 qHash() 는
+     *         쓰지 않음
+     */
+    static quint32 hash(QStringView word, bool fold = false)
+    {
+        quint32 h = 2166136261u;
+
+        for (int i = 0; i < word.size(); ++i)
+        {
+            ushort ch = word.at(i).unicode();
+
+            if (fold && ch >= 'A' && ch <= 'Z')
+                ch += 'a' - 'A';
+
+            h = (h ^ ch) * 16777619u;
+        }
+
+        return h;
+    }
+
+    /**
+     * @brief 이미지 머리를 얻음
+     * @return 이미지 머리
+     */
+    const Header &header() const
+    {
+        return *reinterpret_cast<const Header *>(_data);
+    }
+
+    /**
+     * @brief 이미지 안의 표를 얻음
+     * @param offset 이미지 시작에서 센 바이트 수
+     * @return 표의 시작
+     */
+    template <typename T> const T *at(quint32 offset) const
+    {
+        return reinterpret_cast<const T *>(_data + offset);
+    }
+
+    /**
+     * @brief 문자열 풀의 문자열을 얻음
+     * @param offset 문자열 풀에서 센 문자 수
+     * @param length 길이
+     * @return 이미지를 가리키는 문자열
+     */
+    QStringView string(quint32 offset, quint32 length) const
+    {
+        return QStringView(at<QChar>(header().stringsOffset) + offset,
+                           length);
+    }
+
+    /**
+     * @brief 언어 이름을 얻음
+     * @return 언어 이름
+     */
+    QString name() const
+    {
+        return string(header().nameOffset, header().nameLength).toString();
+    }
+
+    /**
+     * @brief 캐시 파일을 사상하여 쓰는지 알려줌
+     * @return 사상했으면 true, 컴파일한 이미지를 메모리에 가지면 false
+     */
+    bool isMapped() const
+    {
+        return _image.isEmpty();
+    }
+
+private:
+    QByteArray _image;  /// 컴파일한 이미지. 캐시를 사상했으면 비어 있음
+    QFile _file;        /// 사상한 캐시 파일
+    const uchar *_data; /// 이미지 시작
+
+    Grammar();
+    Q_DISABLE_COPY(Grammar)
+
+    static bool isValid(const uchar *data, qint64 size,
+                        const QByteArray &digest);
+};
+
+#endif // GRAMMAR_H
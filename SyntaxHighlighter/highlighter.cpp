@@ -0,0 +1,418 @@
+/****************************************************************************
+**
+** highlighter.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file highlighter.cpp
+ */
+
+#include "highlighter.h"
+
+#include <QTextDocument>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+/**
+ * @brief Highlighter 생성자
+ * @param parent 부모 객체
+ * @remark 강조할 문서는 setDocument() 로 설정함
+ */
+Highlighter::Highlighter(QObject *parent)
+    : QSyntaxHighlighter(parent)
+    , _generation(0)
+    , _lexGeneration(0)
+    , _waiting(false)
+    , _firstVisible(0)
+    , _lastVisible(-1)
+    , _blockCount(0)
+    , _paintSerial(0)
+{
+    // 토큰 종류마다 글자색 설정
+    for (int kind = 0; kind < TokenMatcher::KindCount; ++kind)
+    {
+        const char *name = colorName(static_cast<TokenMatcher::Kind>(kind));
+
+        if (name)
+            _formats[kind].setForeground(QColor(name));
+    }
+
+    // 배경 분석에서는 줄의 상태만 얻고, 색은 보이는 줄만 칠할 때 분석함
+    _parallelLexer.setSpansEnabled(false);
+
+    connect(&_watcher, SIGNAL(finished()), this, SLOT(lexFinished()));
+}
+
+/**
+ * @brief Highlighter 소멸자
+ * @remark 배경 분석은 _cancel 을 보므로, 멈추고 끝날 때까지 기다림
+ */
+Highlighter::~Highlighter()
+{
+    _cancel.store(1);
+    _watcher.waitForFinished();
+}
+
+/**
+ * @brief 토큰 종류의 글자색 이름을 돌려줌
+ * @param kind 토큰 종류
+ * @return 색 이름. 색을 칠하지 않는 종류이면 0
+ */
+const char *Highlighter::colorName(TokenMatcher::Kind kind)
+{
+    switch (kind)
+    {
+    case TokenMatcher::Keyword:
+        return "#808000";
+
+    case TokenMatcher::Directive:
+        return "blue";
+
+    case TokenMatcher::Operator:
+        return "red";
+
+    case TokenMatcher::String:
+    case TokenMatcher::Char:
+    case TokenMatcher::Comment:
+    case TokenMatcher::LineComment:
+        return "green";
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 강조할 문서를 설정함
+ * @param document 강조할 문서
+ * @remark QSyntaxHighlighter 보다 먼저 문서의 바뀐 내용을 받도록, 문서에
+ *         연결한 뒤 QSyntaxHighlighter::setDocument() 를 부름
+ */
+void Highlighter::setDocument(QTextDocument *document)
+{
+    if (this->document())
+        disconnect(this->document(), 0, this, 0);
+
+    _painted.clear();
+    _blockCount = 0;
+
+    if (document)
+    {
+        _blockCount = document->blockCount();
+
+        connect(document, SIGNAL(contentsChange(int,int,int)),
+                this, SLOT(documentChange(int,int,int)));
+    }
+
+    QSyntaxHighlighter::setDocument(document);
+}
+
+/**
+ * @brief 언어를 바꿈
+ * @param grammar 언어 정의
+ * @remark 문서 전체를 다시 강조함. 큰 문서는 배경에서 다시 분석하고, 그
+ *         동안 칠한 줄은 옛 색을 유지함
+ */
+void Highlighter::setGrammar(const QSharedPointer<const Grammar> &grammar)
+{
+    _lexer.setGrammar(grammar);
+    _parallelLexer.setGrammar(grammar);
+
+    if (!document())
+        return;
+
+    if (document()->characterCount() < MinBackgroundLength)
+    {
+        rehighlight();
+
+        return;
+    }
+
+    // 분석 중이면 멈추고, 끝나면 새 언어로 다시 분석함
+    _cancel.store(1);
+
+    highlightInBackground();
+}
+
+/**
+ * @brief 문서 전체를 배경에서 분석하여 강조함
+ * @remark setDocument() 다음에 부름. 작은 문서는 setDocument() 가 예약한
+ *         전체 강조에서 바로 분석함
+ */
+void Highlighter::highlightInBackground()
+{
+    if (!document() || document()->characterCount() < MinBackgroundLength)
+        return;
+
+    _generation++;
+
+    if (!_watcher.isRunning())
+        startLexing();
+}
+
+/**
+ * @brief 문서가 바뀌었을 때 배경 분석을 다시 시작함
+ * @remark 배경 분석 결과를 기다리는 중이 아니면 아무것도 하지 않음. 분석
+ *         중이면 취소하고, 끝나면 바뀐 텍스트로 다시 분석함
+ */
+void Highlighter::restartLexing()
+{
+    if (!_waiting)
+        return;
+
+    _generation++;
+    _cancel.store(1);
+}
+
+/**
+ * @brief 보이는 줄 범위를 설정함
+ * @param first 보이는 첫 줄 번호
+ * @param last 보이는 마지막 줄 번호
+ * @remark 아직 칠하지 않은 줄을 칠함
+ */
+void Highlighter::setVisibleBlocks(int first, int last)
+{
+    _firstVisible = first;
+    _lastVisible = last;
+
+    paintVisibleBlocks();
+}
+
+/**
+ * @brief 문서 텍스트의 복사본을 스레드 풀에서 분석하기 시작함
+ */
+void Highlighter::startLexing()
+{
+    _lexGeneration = _generation;
+    _cancel.store(0);
+    _waiting = true;
+
+    // 분석기와 텍스트의 복사본으로 분석하므로, 그동안 문서가 바뀌어도 안전함
+    _watcher.setFuture(QtConcurrent::run(_parallelLexer, &ParallelLexer::lex,
+                                         document()->toPlainText(), &_cancel));
+}
+
+/**
+ * @brief 보이는 줄과 앞뒤 여유 줄 중 칠하지 않은 줄을 칠함
+ * @remark 칠한 줄이 너무 많으면 오래 보지 않은 줄의 색을 지움
+ */
+void Highlighter::paintVisibleBlocks()
+{
+    if (!document())
+        return;
+
+    int first = qMax(_firstVisible - MarginBlocks, 0);
+    int last = _lastVisible + MarginBlocks;
+
+    QTextBlock block = document()->findBlockByNumber(first);
+
+    for (int i = first; i <= last && block.isValid(); ++i)
+    {
+        QHash<int, quint64>::iterator it = _painted.find(i);
+
+        // 칠한 줄은 본 순번만 바꿈
+        if (it != _painted.end())
+            it.value() = ++_paintSerial;
+        else
+            rehighlightBlock(block);
+
+        block = block.next();
+    }
+
+    evictBlocks();
+}
+
+/**
+ * @brief 오래 보지 않은 줄의 색을 지움
+ * @remark 칠한 줄이 MaxPaintedBlocks 보다 많아지면 3/4 이 될 때까지 지움.
+ *         한 번에 여러 줄을 지워 지우는 비용을 나누어 냄
+ */
+void Highlighter::evictBlocks()
+{
+    if (_painted.size() <= MaxPaintedBlocks)
+        return;
+
+    QVector<quint64> serials;
+
+    serials.reserve(_painted.size());
+
+    foreach (quint64 serial, _painted)
+        serials.append(serial);
+
+    // 지울 줄 중 가장 늦게 본 순번
+    int count = _painted.size() - MaxPaintedBlocks * 3 / 4;
+
+    std::nth_element(serials.begin(), serials.begin() + count - 1,
+                     serials.end());
+
+    quint64 newest = serials.at(count - 1);
+
+    QVector<int> blocks;
+
+    for (QHash<int, quint64>::const_iterator it = _painted.constBegin();
+         it != _painted.constEnd(); ++it)
+    {
+        if (it.value() <= newest && !isNearVisible(it.key()))
+            blocks.append(it.key());
+    }
+
+    // 목록에서 먼저 빼고 다시 강조하면 색을 칠하지 않음. 텍스트가 그대로이므로
+    // 상태도 그대로여서 다음 줄로 이어지지 않음
+    foreach (int number, blocks)
+    {
+        _painted.remove(number);
+
+        rehighlightBlock(document()->findBlockByNumber(number));
+    }
+}
+
+/**
+ * @brief 배경 분석이 끝났을 때 호출됨
+ * @remark 그동안 텍스트가 바뀌었으면 다시 분석함
+ */
+void Highlighter::lexFinished()
+{
+    if (!document() || !_waiting)
+        return;
+
+    if (_lexGeneration != _generation)
+    {
+        startLexing();
+
+        return;
+    }
+
+    LexedText lexed = _watcher.result();
+
+    _waiting = false;
+
+    // 모든 줄의 상태를 저장. 줄을 칠할 때 상태가 바뀌지 않으므로
+    // QSyntaxHighlighter 가 다음 줄로 이어서 다시 강조하지 않음
+    QTextBlock block = document()->firstBlock();
+
+    for (int i = 0; i < lexed.states.size() && block.isValid(); ++i)
+    {
+        block.setUserState(lexed.states.at(i));
+        block = block.next();
+    }
+
+    // 기다리는 동안 칠한 줄은 언어나 텍스트가 바뀌었을 수 있으므로 새 상태로
+    // 다시 칠함
+    foreach (int number, _painted.keys())
+    {
+        QTextBlock painted = document()->findBlockByNumber(number);
+
+        if (painted.isValid())
+            rehighlightBlock(painted);
+        else
+            _painted.remove(number);
+    }
+
+    paintVisibleBlocks();
+}
+
+/**
+ * @brief 문서의 내용이 바뀌었을 때 호출됨
+ * @param position 바뀐 위치
+ * @param charsRemoved 지워진 문자 수
+ * @param charsAdded 더해진 문자 수
+ * @remark QSyntaxHighlighter 가 바뀐 줄을 다시 강조하기 전에 불림. 줄이
+ *         늘거나 줄었으면 바뀐 줄 뒤의 칠한 줄 번호를 그만큼 옮김
+ */
+void Highlighter::documentChange(int position, int charsRemoved,
+                                 int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    Q_UNUSED(charsAdded);
+
+    int delta = document()->blockCount() - _blockCount;
+
+    _blockCount = document()->blockCount();
+
+    if (delta == 0 || _painted.isEmpty())
+        return;
+
+    int changed = document()->findBlock(position).blockNumber();
+
+    QHash<int, quint64> painted;
+
+    for (QHash<int, quint64>::const_iterator it = _painted.constBegin();
+         it != _painted.constEnd(); ++it)
+    {
+        int number = it.key();
+
+        // 바뀐 줄 뒤의 줄은 옮기고, 지워진 줄은 뺌
+        if (number > changed)
+        {
+            number += delta;
+
+            if (number <= changed)
+                continue;
+        }
+
+        painted.insert(number, it.value());
+    }
+
+    _painted = painted;
+}
+
+/**
+ * @brief 한 줄을 문법 강조함
+ * @param text 줄의 텍스트
+ * @remark 이전 줄이 끝날 때의 상태에서 시작하고, 이 줄이 끝날 때의 상태를
+ *         저장함. 저장된 상태가 바뀌면 QSyntaxHighlighter 가 다음 줄도
+ *         다시 강조함. 색은 보이는 줄 근처이거나 이미 칠한 줄에만 칠함
+ */
+void Highlighter::highlightBlock(const QString &text)
+{
+    int number = currentBlock().blockNumber();
+    bool paint = isNearVisible(number) || _painted.contains(number);
+
+    // 배경 분석 결과를 기다리는 중이면 칠할 줄만 저장된 상태에서 분석하여
+    // 임시로 칠하고, 분석이 끝나면 다시 칠함
+    if (_waiting && !paint)
+        return;
+
+    // 첫 줄이거나 아직 분석하지 않은 줄 다음이면 -1. 언어를 바꾸기 전의
+    // 상태이면 블럭 수보다 클 수 있음
+    int previous = previousBlockState();
+
+    TokenLexer::State state = previous < 0 || previous >= _lexer.stateCount()
+            ? TokenLexer::Normal : static_cast<TokenLexer::State>(previous);
+
+    _spans.clear();
+
+    state = _lexer.lexLine(text, state, &_spans);
+
+    if (paint)
+    {
+        foreach (const TokenLexer::Span &span, _spans)
+            setFormat(span.start, span.length, _formats[span.kind]);
+
+        _painted.insert(number, ++_paintSerial);
+    }
+
+    // 기다리는 중에는 상태를 그대로 두어 다음 줄로 이어서 강조하지 않음
+    if (!_waiting)
+        setCurrentBlockState(state);
+}
@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** highlighter.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file highlighter.h
+ */
+
+#ifndef HIGHLIGHTER_H
+#define HIGHLIGHTER_H
+
+#include "parallellexer.h"
+
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSyntaxHighlighter>
+#include <QTextCharFormat>
+
+/**
+ * @brief 문법 강조기 클래스
+ *
+ * 문서의 줄(QTextBlock)마다 줄이 끝날 때의 토큰 분석 상태를 저장해 둔다.
+ * 문서가 바뀌면 바뀐 줄만 다시 분석하고, 그 줄이 끝날 때의 상태가 바뀌었을
+ * 때만 다음 줄로 이어서 분석한다. 색은 HTML 을 거치지 않고 줄의 형식으로
+ * 바로 적용한다.
+ *
+ * 상태는 모든 줄이 가지지만, 색은 보이는 줄과 그 앞뒤 여유 줄에만 칠한다.
+ * 스크롤하여 새로 보이는 줄은 저장된 상태에서 그 줄만 분석하여 칠한다.
+ * 칠한 줄은 가장 오래 보지 않은 줄부터 색을 지워, 큰 문서에서도 칠한 줄의
+ * 수를 일정하게 유지한다.
+ *
+ * 큰 문서는 highlightInBackground() 로 처음 전체를 강조할 때, 문서 텍스트의
+ * 복사본을 스레드 풀에서 ParallelLexer 로 분석하여 줄의 상태만 얻는다.
+ * 분석하는 동안에는 보이는 줄만 저장된 상태(없으면 Normal)에서 그 줄씩
+ * 분석하여 임시로 칠하고, 상태는 바꾸지 않는다. 그동안 텍스트가 바뀌면
+ * 분석을 취소하고 바뀐 텍스트로 다시 분석한다. 분석이 끝나면 모든 줄의
+ * 상태를 저장하고 칠한 줄을 새 상태로 다시 칠한다.
+ *
+ * 언어는 setGrammar() 로 바꾸며, 바꾸면 문서 전체를 다시 강조한다.
+ */
+class Highlighter : public QSyntaxHighlighter
+{
+    Q_OBJECT
+
+public:
+    enum
+    {
+        MinBackgroundLength = 64 * 1024,    /// 배경에서 분석할 최소 문자 수
+        MarginBlocks = 100,                 /// 보이는 줄 앞뒤로 더 칠할 줄 수
+        MaxPaintedBlocks = 8192             /// 색을 칠해 둘 최대 줄 수
+    };
+
+    explicit Highlighter(QObject *parent = 0);
+    ~Highlighter();
+
+    static const char *colorName(TokenMatcher::Kind kind);
+
+    void setDocument(QTextDocument *document);
+    void setGrammar(const QSharedPointer<const Grammar> &grammar);
+
+    void highlightInBackground();
+    void restartLexing();
+    void setVisibleBlocks(int first, int last);
+
+protected:
+    void highlightBlock(const QString &text) Q_DECL_OVERRIDE;
+
+private:
+    TokenLexer _lexer;                  /// 줄 단위 토큰 분석기
+    QVector<TokenLexer::Span> _spans;   /// 색을 칠할 구간들
+    QTextCharFormat _formats[TokenMatcher::KindCount];  /// 토큰 종류마다의
+                                                        /// 형식
+
+    ParallelLexer _parallelLexer;       /// 배경 분석에 쓰는 병렬 분석기
+    QFutureWatcher<LexedText> _watcher; /// 배경 분석 감시자
+    QAtomicInt _cancel;                 /// 0 이 아니면 배경 분석을 멈춤
+    int _generation;                    /// 텍스트가 바뀔 때마다 늘어나는 세대
+    int _lexGeneration;                 /// 분석 중인 텍스트의 세대
+    bool _waiting;                      /// 배경 분석 결과를 기다리는 중
+
+    int _firstVisible;                  /// 보이는 첫 줄 번호
+    int _lastVisible;                   /// 보이는 마지막 줄 번호
+    int _blockCount;                    /// 문서의 줄 수
+    QHash<int, quint64> _painted;       /// 색을 칠한 줄 번호와 마지막으로
+                                        /// 칠하거나 본 순번
+    quint64 _paintSerial;               /// 칠하거나 볼 때마다 늘어나는 순번
+
+    /**
+     * @brief 색을 칠할 범위의 줄인지 알려줌
+     * @param block 줄 번호
+     * @return 보이는 줄이거나 앞뒤 여유 줄이면 true, 아니면 false
+     */
+    bool isNearVisible(int block) const
+    {
+        return block >= _firstVisible - MarginBlocks
+                && block <= _lastVisible + MarginBlocks;
+    }
+
+    void startLexing();
+    void paintVisibleBlocks();
+    void evictBlocks();
+
+private slots:
+    void lexFinished();
+    void documentChange(int position, int charsRemoved, int charsAdded);
+};
+
+#endif // HIGHLIGHTER_H
@@ -0,0 +1,669 @@
+/****************************************************************************
+**
+** highlightercli.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file highlightercli.cpp
+ */
+
+#include "highlightercli.h"
+#include "grammar.h"
+#include "htmlwriter.h"
+#include "legacyhighlighter.h"
+#include "memorystats.h"
+#include "parallellexer.h"
+#include "tokenlexer.h"
+#include "tokenparser.h"
+
+#include <QCommandLineParser>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief 쓴 바이트 수만 세는 장치
+ */
+class NullDevice : public QIODevice
+{
+public:
+    NullDevice()
+        : _written(0)
+    {
+    }
+
+    /**
+     * @brief 쓴 바이트 수를 돌려줌
+     * @return 쓴 바이트 수
+     */
+    qint64 written() const
+    {
+        return _written;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(maxSize);
+
+        return -1;
+    }
+
+    qint64 writeData(const char *data, qint64 maxSize) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(data);
+
+        _written += maxSize;
+
+        return maxSize;
+    }
+
+private:
+    qint64 _written;    /// 쓴 바이트 수
+};
+
+/**
+ * @brief 한 분석기를 잰 결과
+ */
+struct Row
+{
+    double seconds;         /// 한 번 실행에 걸린 초
+    double allocationsPerKb;    /// 입력 1 KB 당 할당 횟수. 세지 않으면 -1
+    qint64 peakRss;         /// 한 번 실행하는 동안의 최대 RSS. 모르면 -1
+};
+
+} // namespace
+
+/**
+ * @brief 명령행 모드로 실행해야 하는지 확인
+ * @param argc 인수 개수
+ * @param argv 인수 배열
+ * @return 명령행 모드 옵션이 있으면 true, 아니면 false
+ * @remark QApplication 을 만들기 전에 부르므로 argv 를 직접 살펴봄
+ */
+bool HighlighterCli::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--benchmark"))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief 명령행 모드를 실행함
+ * @param arguments 명령행 인수
+ * @return 모든 말뭉치를 읽었으면 0, 아니면 0 이 아닌 값
+ */
+int HighlighterCli::exec(const QStringList &arguments)
+{
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+            QObject::tr("창 없이 문법 강조 성능을 잽니다."));
+    parser.addHelpOption();
+
+    QCommandLineOption benchmarkOption("benchmark",
+            QObject::tr("토큰 분석과 HTML 생성 성능을 잼"));
+    QCommandLineOption languageOption("language",
+            QObject::tr("언어 정의 파일. 없으면 C/C++"),
+            QObject::tr("파일"), ":/languages/cpp.lang");
+    QCommandLineOption maxSizeOption("max-size",
+            QObject::tr("합성 말뭉치의 최대 크기. MB 단위. 기본값 50"),
+            QObject::tr("MB"), "50");
+
+    parser.addOption(benchmarkOption);
+    parser.addOption(languageOption);
+    parser.addOption(maxSizeOption);
+    parser.addPositionalArgument("paths",
+            QObject::tr("잴 소스 파일이나 디렉토리들. 없으면 합성한 C++ "
+                        "소스"),
+            QObject::tr("[경로...]"));
+
+    parser.process(arguments);
+
+    const QString languageFile = parser.value(languageOption);
+    QString error;
+    QSharedPointer<const Grammar> grammar = Grammar::load(languageFile, &error);
+
+    if (grammar.isNull())
+    {
+        err << error << '\n';
+
+        return 1;
+    }
+
+    if (!MemoryStats::countsAllocations())
+        err << QObject::tr("할당 횟수를 세지 않습니다. glibc 에서 "
+                       "CONFIG+=allocation_stats 로 빌드하세요.")
+            << '\n';
+
+    // 잴 때 오래 걸리므로 경고를 먼저 내보냄
+    err.flush();
+
+    benchmarkGrammar(languageFile);
+
+    if (parser.positionalArguments().isEmpty())
+    {
+        static const int sizes[] = {
+            1000, 64 * 1000, 1000 * 1000, 8 * 1000 * 1000, 50 * 1000 * 1000
+        };
+
+        const double maxSize = parser.value(maxSizeOption).toDouble() * 1e6;
+
+        for (int corpus = 0; corpus < CorpusCount; ++corpus)
+        {
+            for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+            {
+                if (sizes[i] > maxSize)
+                    break;
+
+                benchmarkCorpus(corpusName(static_cast<Corpus>(corpus)),
+                                sampleSource(static_cast<Corpus>(corpus),
+                                             sizes[i]),
+                                grammar);
+            }
+        }
+
+        return 0;
+    }
+
+    int failed = 0;
+
+    foreach (const QString &path, parser.positionalArguments())
+    {
+        QString text;
+
+        if (!readCorpus(path, &text))
+        {
+            err << QObject::tr("열 수 없음: ") << path << '\n';
+            err.flush();
+
+            failed++;
+
+            continue;
+        }
+
+        benchmarkCorpus(path, text, grammar);
+    }
+
+    return failed ? 1 : 0;
+}
+
+/**
+ * @brief 합성 말뭉치의 이름을 얻음
+ * @param corpus 말뭉치 종류
+ * @return 이름
+ */
+QString HighlighterCli::corpusName(Corpus corpus)
+{
+    switch (corpus)
+    {
+    case CommentCorpus:
+        return QObject::tr("합성 C++, 주석 많음");
+
+    case StringCorpus:
+        return QObject::tr("합성 C++, 문자열 많음");
+
+    case OperatorCorpus:
+        return QObject::tr("합성 C++, 기호 많음");
+
+    default:
+        break;
+    }
+
+    return QObject::tr("합성 C++");
+}
+
+/**
+ * @brief 합성한 C++ 소스를 만듦
+ * @param corpus 말뭉치 종류
+ * @param size 문자 수
+ * @return 말뭉치 종류의 본보기 소스를 되풀이한 소스
+ */
+QString HighlighterCli::sampleSource(Corpus corpus, int size)
+{
+    static const char mixed[] =
+        "/*\n"
+        " * Sample source for the lexer benchmark\n"
+        " */\n"
+        "\n"
+        "#include <stdio.h>\n"
+        "#  define MAX_COUNT 100  // maximum count\n"
+        "\n"
+        "static const char *names[] = {\"alpha\", \"beta\\\"s\", 'g'};\n"
+        "\n"
+        "template <typename T>\n"
+        "class Counter : public Base<T>\n"
+        "{\n"
+        "public:\n"
+        "    explicit Counter(int start = 0) : _count(start) {}\n"
+        "\n"
+        "    virtual int next() const\n"
+        "    {\n"
+        "        for (int i = 0; i < MAX_COUNT && _count >= 0; ++i)\n"
+        "            if (_table[i % 16] != NULL) return _table[i]->value();\n"
+        "\n"
+        "        return sizeof(T) * 2 + (_count << 1) - ~0u; /* done */\n"
+        "    }\n"
+        "\n"
+        "private:\n"
+        "    mutable int _count;\n"
+        "};\n"
+        "\n";
+
+    static const char comments[] =
+        "/**\n"
+        " * @brief Returns the number of items from the given position\n"
+        " * @param index position of the first item, counted from zero\n"
+        " * @return number of items, or -1 if the index is out of range\n"
+        " * @remark the count is not cached, so this walks the whole list\n"
+        " */\n"
+        "int count(int index); // see also size()\n"
+        "\n"
+        "// TODO: cache the result. The list rarely changes between calls,\n"
+        "//       so most lookups could skip the walk entirely. \\\n"
+        "//       This line is continued by the backslash above.\n"
+        "/* int oldCount(int index) { return size() - index; } */\n"
+        "\n";
+
+    static const char strings[] =
+        "static const char *messages[] = {\n"
+        "    \"cannot open file \\\"%s\\\": %s\\n\",\n"
+        "    \"unexpected character '%c' at line %d, column %d\",\n"
+        "    \"usage: tool [-v] [-o output] input...\\n\\t-v\\tverbose\",\n"
+        "    \"keywords inside strings: if for while return NULL\",\n"
+        "};\n"
+        "static const char quotes[] = {'\\'', '\"', '\\\\', 'x', '\\n'};\n"
+        "puts(\"/* not a comment */ // nor this\");\n"
+        "\n";
+
+    static const char operators[] =
+        "x = (a + b) * c - d / e % f;\n"
+        "y = ((p[i] << 2) | (q[j] >> 3)) & ~mask ^ flags;\n"
+        "z = a < b ? (c <= d && e >= f) : !(g == h || i != j);\n"
+        "v[k] += w[k] * s - t[k]; u->n = (m.x - m.y) * -1;\n"
+        "r = {a, b, c}; s = *p++ + --*q; t = &u[0] != &v[1];\n"
+        "\n";
+
+    const char *sample;
+
+    switch (corpus)
+    {
+    case CommentCorpus:
+        sample = comments;
+        break;
+
+    case StringCorpus:
+        sample = strings;
+        break;
+
+    case OperatorCorpus:
+        sample = operators;
+        break;
+
+    default:
+        sample = mixed;
+        break;
+    }
+
+    QString unit(QString::fromLatin1(sample));
+    QString source;
+
+    source.reserve(size + unit.length());
+
+    while (source.length() < size)
+        source.append(unit);
+
+    source.truncate(size);
+
+    return source;
+}
+
+/**
+ * @brief 말뭉치를 읽음
+ * @param path 소스 파일이나 디렉토리
+ * @param text 읽은 소스를 돌려받음. 디렉토리이면 그 안의 C/C++ 소스를
+ *             모두 이어 붙임
+ * @return 읽었으면 true, 아니면 false
+ */
+bool HighlighterCli::readCorpus(const QString &path, QString *text)
+{
+    text->clear();
+
+    if (!QFileInfo(path).isDir())
+    {
+        QFile file(path);
+
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+
+        *text = QString::fromUtf8(file.readAll());
+
+        return true;
+    }
+
+    QStringList filters;
+
+    filters << "*.c" << "*.cc" << "*.cpp" << "*.cxx"
+            << "*.h" << "*.hh" << "*.hpp" << "*.hxx";
+
+    QDirIterator it(path, filters, QDir::Files, QDirIterator::Subdirectories);
+
+    while (it.hasNext())
+    {
+        QFile file(it.next());
+
+        if (file.open(QIODevice::ReadOnly))
+            text->append(QString::fromUtf8(file.readAll()));
+    }
+
+    return !text->isEmpty();
+}
+
+/**
+ * @brief 함수를 충분히 여러 번 실행해 한 번에 걸리는 시간을 잼
+ * @param func 잴 함수
+ * @return 한 번 실행에 걸린 초
+ * @remark 0.2 초가 지나고 적어도 3 번 실행할 때까지 되풀이함
+ */
+template <typename Func>
+static double measure(Func func)
+{
+    QElapsedTimer timer;
+    int runs = 0;
+
+    timer.start();
+
+    do
+    {
+        func();
+        runs++;
+    } while (runs < 3 || timer.nsecsElapsed() < 200000000);
+
+    return timer.nsecsElapsed() / 1e9 / runs;
+}
+
+/**
+ * @brief 함수의 속도와 메모리 사용을 잼
+ * @param length 입력 문자 수
+ * @param func 잴 함수
+ * @return 잰 결과
+ * @remark 먼저 한 번 실행하여 할당 횟수와 최대 RSS 를 재고, 그다음
+ *         measure() 로 시간을 잼
+ */
+template <typename Func>
+static Row measureRow(int length, Func func)
+{
+    Row row;
+
+    quint64 allocations = MemoryStats::allocations();
+
+    MemoryStats::resetPeakRss();
+
+    func();
+
+    row.peakRss = MemoryStats::peakRss();
+    row.allocationsPerKb =
+            MemoryStats::countsAllocations()
+                ? (MemoryStats::allocations() - allocations)
+                  / (qMax(length, 1) / 1e3)
+                : -1;
+    row.seconds = measure(func);
+
+    return row;
+}
+
+/**
+ * @brief 잰 결과를 한 줄로 씀
+ * @param out 출력 스트림
+ * @param name 분석기 이름
+ * @param length 입력 문자 수
+ * @param row 잰 결과
+ * @param note 덧붙일 말
+ */
+static void printRow(QTextStream &out, const QString &name, int length,
+                     const Row &row, const QString &note)
+{
+    out << QString("%1 %2 %3 %4  %5")
+               .arg(name, -14)
+               .arg(length / row.seconds / 1e6, 9, 'f', 1)
+               .arg(row.allocationsPerKb < 0
+                        ? QString("-")
+                        : QString::number(row.allocationsPerKb, 'f', 2), 10)
+               .arg(row.peakRss < 0
+                        ? QString("-")
+                        : QString::number(row.peakRss / 1e6, 'f', 1), 10)
+               .arg(note)
+        << '\n';
+
+    // 말뭉치가 크면 한 줄을 재는 데 오래 걸리므로 줄마다 내보냄
+    out.flush();
+}
+
+/**
+ * @brief 언어 정의를 불러오는 성능을 잼
+ * @param fileName 정의 파일
+ * @remark 정의를 컴파일할 때와, 캐시를 사상하여 불러올 때를 비교함. 캐시를
+ *         쓸 수 없으면 불러올 때마다 컴파일함
+ */
+void HighlighterCli::benchmarkGrammar(const QString &fileName)
+{
+    QTextStream out(stdout);
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    const QByteArray definition = file.readAll();
+
+    out << QObject::tr("언어 정의 (%1, %2 바이트)")
+               .arg(fileName).arg(definition.size())
+        << '\n';
+
+    double compileTime = measure([&]
+    {
+        Grammar::compile(definition);
+    });
+
+    out << QString("%1 %2 us")
+               .arg("compile", -12)
+               .arg(compileTime * 1e6, 8, 'f', 1)
+        << '\n';
+
+    bool mapped = false;
+
+    double loadTime = measure([&]
+    {
+        mapped = Grammar::load(fileName)->isMapped();
+    });
+
+    out << QString("%1 %2 us, %3")
+               .arg("load", -12)
+               .arg(loadTime * 1e6, 8, 'f', 1)
+               .arg(mapped ? QObject::tr("캐시 사상")
+                           : QObject::tr("캐시 없음. 컴파일함"))
+        << '\n';
+}
+
+/**
+ * @brief 말뭉치 하나로 분석기들의 성능을 잼
+ * @param name 말뭉치 이름
+ * @param text 말뭉치
+ * @param grammar 새 분석기들이 쓸 언어 정의
+ * @remark 예전 강조기는 느리므로 LegacyMaxLength 이하의 말뭉치에서만 잼.
+ *         MB/s 와 1 KB 는 문자 수 기준이고, 최대 RSS 는 입력과 이미 할당된
+ *         메모리를 포함한 프로세스 전체의 값
+ */
+void HighlighterCli::benchmarkCorpus(const QString &name, const QString &text,
+                                     const QSharedPointer<const Grammar> &grammar)
+{
+    QTextStream out(stdout);
+
+    const int length = text.length();
+    const int lines = text.count('\n') + 1;
+
+    out << '\n'
+        << QObject::tr("%1 (%2 문자, %3 줄)")
+               .arg(name).arg(length).arg(lines)
+        << '\n'
+        << QString("%1 %2 %3 %4")
+               .arg("", -14)
+               .arg("MB/s", 9)
+               .arg(QObject::tr("할당/KB"), 10)
+               .arg(QObject::tr("RSS(MB)"), 10)
+        << '\n';
+
+    out.flush();
+
+    // 예전 파이프라인. TokenParser 와 TokenAbstract 로 HTML 문자열을 만듦
+    Row legacy = {0, -1, -1};
+
+    if (length <= LegacyMaxLength)
+    {
+        LegacyHighlighter highlighter;
+        int htmlLength = 0;
+
+        legacy = measureRow(length, [&]
+        {
+            htmlLength = highlighter.toHtml(text).length();
+        });
+
+        printRow(out, "Legacy", length, legacy,
+                 QObject::tr("HTML %1 문자").arg(htmlLength));
+    }
+    else
+    {
+        out << QString("%1 %2")
+                   .arg("Legacy", -14)
+                   .arg(QObject::tr("건너뜀. %1 문자 초과")
+                            .arg(int(LegacyMaxLength)))
+            << '\n';
+    }
+
+    int tokens = 0;
+
+    Row parser = measureRow(length, [&]
+    {
+        TokenParser parser(text);
+
+        tokens = 0;
+
+        while (parser.hasNext())
+        {
+            parser.next();
+            tokens++;
+        }
+    });
+
+    printRow(out, "TokenParser", length, parser,
+             QObject::tr("토큰 %1 개").arg(tokens));
+
+    TokenLexer lexer(grammar);
+    QVector<TokenLexer::Span> spans;
+    int spanCount = 0;
+
+    Row serial = measureRow(length, [&]
+    {
+        QStringView view(text);
+        TokenLexer::State state = TokenLexer::Normal;
+
+        spanCount = 0;
+
+        // 줄마다 구간 배열을 다시 씀
+        for (int start = 0; start <= view.size(); )
+        {
+            int end = text.indexOf('\n', start);
+
+            if (end < 0)
+                end = view.size();
+
+            spans.clear();
+
+            state = lexer.lexLine(view.mid(start, end - start), state,
+                                  &spans);
+            spanCount += spans.size();
+
+            start = end + 1;
+        }
+    });
+
+    printRow(out, "TokenLexer", length, serial,
+             QObject::tr("구간 %1 개").arg(spanCount));
+
+    ParallelLexer parallelLexer(grammar);
+    int parallelSpanCount = 0;
+
+    Row parallel = measureRow(length, [&]
+    {
+        parallelSpanCount = parallelLexer.lex(text).spans.size();
+    });
+
+    printRow(out, "ParallelLexer", length, parallel,
+             QObject::tr("구간 %1 개").arg(parallelSpanCount));
+
+    NullDevice device;
+
+    device.open(QIODevice::WriteOnly);
+
+    HtmlWriter writer(&device);
+
+    writer.setGrammar(grammar);
+
+    qint64 htmlSize = 0;
+
+    Row html = measureRow(length, [&]
+    {
+        qint64 written = device.written();
+
+        writer.write(text);
+
+        htmlSize = device.written() - written;
+    });
+
+    printRow(out, "HtmlWriter", length, html,
+             QObject::tr("출력 %1 MB, %2 MB/s")
+                .arg(htmlSize / 1e6, 0, 'f', 1)
+                .arg(htmlSize / html.seconds / 1e6, 0, 'f', 1));
+
+    out << QString("%1 %2x (TokenLexer / TokenParser)")
+               .arg(QObject::tr("속도 비"), -14)
+               .arg(parser.seconds / serial.seconds, 9, 'f', 1)
+        << '\n';
+
+    if (legacy.seconds > 0)
+    {
+        out << QString("%1 %2x (HtmlWriter / Legacy)")
+                   .arg("", -14)
+                   .arg(legacy.seconds / html.seconds, 9, 'f', 1)
+            << '\n';
+    }
+}
@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** highlightercli.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file highlightercli.h
+ */
+
+#ifndef HIGHLIGHTERCLI_H
+#define HIGHLIGHTERCLI_H
+
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+class Grammar;
+
+/**
+ * @brief 명령행 모드 클래스
+ *
+ * 창 없이 문법 강조 성능을 잰다. 말뭉치마다 예전 강조기(LegacyHighlighter),
+ * TokenParser, TokenLexer, ParallelLexer, HtmlWriter 를 차례로 돌려 MB/s,
+ * 입력 1 KB 당 할당 횟수, 최대 RSS 를 보여준다.
+ *
+ * 파일이나 디렉토리를 주지 않으면 주석이 많은 소스, 문자열이 많은 소스,
+ * 기호가 많은 소스, 이들이 섞인 소스를 1 KB 부터 50 MB 까지 합성하여 잰다.
+ * 디렉토리를 주면 그 안의 C/C++ 소스를 모두 이어 붙여 하나의 말뭉치로
+ * 잰다. 언어 정의를 주면 새 분석기들은 그 언어로 분석하며, 예전 강조기와
+ * TokenParser 는 언제나 C/C++ 로 분석한다.
+ *
+ * @code
+ * SyntaxHighlighter --benchmark
+ * SyntaxHighlighter --benchmark --max-size 8
+ * SyntaxHighlighter --benchmark big.cpp ~/src/project
+ * SyntaxHighlighter --benchmark --language languages/python.lang big.py
+ * @endcode
+ */
+class HighlighterCli
+{
+public:
+    enum
+    {
+        LegacyMaxLength = 1000 * 1000   /// 예전 강조기로 잴 최대 문자 수
+    };
+
+    /**
+     * @brief 합성 말뭉치 종류
+     */
+    enum Corpus
+    {
+        MixedCorpus = 0,    /// 여러 토큰이 섞인 소스
+        CommentCorpus,      /// 주석이 많은 소스
+        StringCorpus,       /// 문자열이 많은 소스
+        OperatorCorpus,     /// 기호가 많은 소스
+        CorpusCount         /// 말뭉치 종류 수
+    };
+
+    static bool isRequested(int argc, char *argv[]);
+
+    int exec(const QStringList &arguments);
+
+private:
+    static QString corpusName(Corpus corpus);
+    static QString sampleSource(Corpus corpus, int size);
+    static bool readCorpus(const QString &path, QString *text);
+
+    static void benchmarkGrammar(const QString &fileName);
+    static void benchmarkCorpus(const QString &name, const QString &text,
+                                const QSharedPointer<const Grammar> &grammar);
+};
+
+#endif // HIGHLIGHTERCLI_H
@@ -0,0 +1,376 @@
+/****************************************************************************
+**
+** htmlwriter.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file htmlwriter.cpp
+ */
+
+#include "htmlwriter.h"
+#include "highlighter.h"
+
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief ASCII 문자의 HTML 이스케이프 표
+ */
+struct EscapeTable
+{
+    const char *entities[128];  /// 문자마다 바꿀 엔티티
+    uchar lengths[128];         /// 엔티티 길이. 0 이면 그대로 씀
+
+    /**
+     * @brief EscapeTable 생성자
+     */
+    EscapeTable()
+    {
+        memset(entities, 0, sizeof(entities));
+        memset(lengths, 0, sizeof(lengths));
+
+        set('<', "&lt;");
+        set('>', "&gt;");
+        set('&', "&amp;");
+    }
+
+    /**
+     * @brief 문자를 바꿀 엔티티를 설정
+     * @param ch 문자
+     * @param entity 엔티티
+     */
+    void set(char ch, const char *entity)
+    {
+        entities[static_cast<uchar>(ch)] = entity;
+        lengths[static_cast<uchar>(ch)] = static_cast<uchar>(strlen(entity));
+    }
+};
+
+const EscapeTable escapeTable;
+
+/**
+ * @brief 문자들을 HTML 로 이스케이프하여 UTF-8 로 씀
+ * @param out 쓸 위치. 문자마다 HtmlWriter::MaxCharBytes 바이트의 공간이
+ *            있어야 함
+ * @param p 첫 문자
+ * @param e 마지막 문자 다음
+ * @return 쓴 바이트 다음 위치
+ * @remark 짝이 없는 서로게이트는 U+FFFD 로 씀
+ */
+inline char *escape(char *out, const ushort *p, const ushort *e)
+{
+    while (p < e)
+    {
+        ushort ch = *p++;
+
+        if (ch < 0x80)
+        {
+            int n = escapeTable.lengths[ch];
+
+            if (!n)
+                *out++ = static_cast<char>(ch);
+            else
+            {
+                memcpy(out, escapeTable.entities[ch], n);
+
+                out += n;
+            }
+        }
+        else if (ch < 0x800)
+        {
+            *out++ = static_cast<char>(0xC0 | (ch >> 6));
+            *out++ = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+        else if (QChar::isSurrogate(ch))
+        {
+            if (QChar::isHighSurrogate(ch) && p < e
+                    && QChar::isLowSurrogate(*p))
+            {
+                uint ucs4 = QChar::surrogateToUcs4(ch, *p++);
+
+                *out++ = static_cast<char>(0xF0 | (ucs4 >> 18));
+                *out++ = static_cast<char>(0x80 | ((ucs4 >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((ucs4 >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (ucs4 & 0x3F));
+            }
+            else
+            {
+                *out++ = '\xEF';
+                *out++ = '\xBF';
+                *out++ = '\xBD';
+            }
+        }
+        else
+        {
+            *out++ = static_cast<char>(0xE0 | (ch >> 12));
+            *out++ = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+    }
+
+    return out;
+}
+
+/**
+ * @brief 바이트 배열을 그대로 씀
+ * @param out 쓸 위치
+ * @param data 바이트 배열
+ * @return 쓴 바이트 다음 위치
+ */
+inline char *copy(char *out, const QByteArray &data)
+{
+    memcpy(out, data.constData(), data.size());
+
+    return out + data.size();
+}
+
+} // namespace
+
+/**
+ * @brief HtmlWriter 생성자
+ * @param device 쓰기로 열린 출력 장치
+ */
+HtmlWriter::HtmlWriter(QIODevice *device)
+    : _device(device)
+    , _buffer(BufferSize, Qt::Uninitialized)
+    , _ok(true)
+{
+    _out = _buffer.data();
+    _end = _out + _buffer.size();
+
+    // 토큰 종류마다 여는 태그를 미리 만듦
+    for (int kind = 0; kind < TokenMatcher::KindCount; ++kind)
+    {
+        const char *name = className(static_cast<TokenMatcher::Kind>(kind));
+
+        if (name)
+            _opens[kind] = QByteArray("<span class=\"")
+                               .append(name).append("\">");
+    }
+}
+
+/**
+ * @brief 토큰 종류의 CSS 클래스 이름을 돌려줌
+ * @param kind 토큰 종류
+ * @return 클래스 이름. 색을 칠하지 않는 종류이면 0
+ * @remark 태그가 짧을수록 출력이 작으므로 두 글자로 함
+ */
+const char *HtmlWriter::className(TokenMatcher::Kind kind)
+{
+    if (!Highlighter::colorName(kind))
+        return 0;
+
+    static const char *const names[TokenMatcher::KindCount] =
+    {
+        0, "kw", "pp", "op", "st", "ch", "cm", "lc", 0
+    };
+
+    return names[kind];
+}
+
+/**
+ * @brief 텍스트를 문법 강조된 HTML 문서로 씀
+ * @param text 텍스트
+ * @param title 문서 제목
+ * @return 장치에 모두 썼으면 true, 아니면 false
+ */
+bool HtmlWriter::write(const QString &text, const QString &title)
+{
+    static const char header[] =
+        "<!DOCTYPE html>\n"
+        "<html>\n"
+        "<head>\n"
+        "<meta charset=\"utf-8\">\n"
+        "<title>";
+    static const char style[] =
+        "</title>\n"
+        "<style>\n"
+        "pre { font-family: \"Courier New\"; font-size: 10pt; }\n";
+    // <pre> 바로 다음의 줄 바꿈 하나는 무시되므로, 텍스트의 첫 줄 바꿈이
+    // 사라지지 않게 하나 넣음
+    static const char body[] =
+        "</style>\n"
+        "</head>\n"
+        "<body>\n"
+        "<pre>\n";
+    static const char footer[] =
+        "</pre>\n"
+        "</body>\n"
+        "</html>\n";
+    _ok = true;
+
+    writeRaw(header, sizeof(header) - 1);
+    writeEscaped(title.constData(), title.constData() + title.length());
+    writeRaw(style, sizeof(style) - 1);
+
+    for (int kind = 0; kind < TokenMatcher::KindCount; ++kind)
+    {
+        const char *name = className(static_cast<TokenMatcher::Kind>(kind));
+
+        if (name)
+            writeRaw(QByteArray(".").append(name).append(" { color: ")
+                         .append(Highlighter::colorName(
+                                     static_cast<TokenMatcher::Kind>(kind)))
+                         .append("; }\n"));
+    }
+
+    writeRaw(body, sizeof(body) - 1);
+
+    QStringView view(text);
+    TokenLexer::State state = TokenLexer::Normal;
+
+    const int length = text.length();
+
+    for (int start = 0; start <= length; )
+    {
+        int eol = text.indexOf('\n', start);
+
+        if (eol < 0)
+            eol = length;
+
+        _spans.clear();
+
+        state = _lexer.lexLine(view.mid(start, eol - start), state, &_spans);
+
+        writeLine(text.constData() + start, eol - start);
+
+        if (eol < length)
+            writeRaw("\n", 1);
+
+        start = eol + 1;
+    }
+
+    writeRaw(footer, sizeof(footer) - 1);
+
+    flush();
+
+    return _ok;
+}
+
+/**
+ * @brief 분석한 줄을 씀
+ * @param line 줄의 첫 문자
+ * @param length 줄의 길이
+ * @remark 줄 전체에 필요한 공간을 한 번에 확보하고, 버퍼 끝을 확인하지
+ *         않고 씀. 같은 종류의 구간이 붙어 있으면 태그를 닫지 않고 이어
+ *         씀. 여러 줄에 걸친 블럭은 줄마다 닫고 다시 엶
+ */
+void HtmlWriter::writeLine(const QChar *line, int length)
+{
+    static const QByteArray close("</span>");
+
+    const ushort *p = reinterpret_cast<const ushort *>(line);
+
+    reserve(qint64(length) * MaxCharBytes
+            + qint64(_spans.size()) * (MaxOpenLength + close.size()));
+
+    char *out = _out;
+    int pos = 0;
+    int opened = TokenMatcher::None;    // 열려 있는 태그의 토큰 종류
+
+    foreach (const TokenLexer::Span &span, _spans)
+    {
+        if (span.kind != opened || span.start != pos)
+        {
+            if (opened != TokenMatcher::None)
+                out = copy(out, close);
+
+            out = escape(out, p + pos, p + span.start);
+
+            opened = _opens[span.kind].isEmpty()
+                    ? TokenMatcher::None : span.kind;
+
+            if (opened != TokenMatcher::None)
+                out = copy(out, _opens[opened]);
+        }
+
+        pos = span.start + span.length;
+
+        out = escape(out, p + span.start, p + pos);
+    }
+
+    if (opened != TokenMatcher::None)
+        out = copy(out, close);
+
+    _out = escape(out, p + pos, p + length);
+}
+
+/**
+ * @brief 바이트들을 그대로 씀
+ * @param data 바이트들
+ * @param length 바이트 수
+ */
+void HtmlWriter::writeRaw(const char *data, int length)
+{
+    reserve(length);
+
+    memcpy(_out, data, length);
+
+    _out += length;
+}
+
+/**
+ * @brief 문자들을 HTML 로 이스케이프하여 UTF-8 로 씀
+ * @param begin 첫 문자
+ * @param end 마지막 문자 다음
+ */
+void HtmlWriter::writeEscaped(const QChar *begin, const QChar *end)
+{
+    reserve(qint64(end - begin) * MaxCharBytes);
+
+    _out = escape(_out, reinterpret_cast<const ushort *>(begin),
+                  reinterpret_cast<const ushort *>(end));
+}
+
+/**
+ * @brief 버퍼에 빈 공간을 확보함
+ * @param bytes 필요한 바이트 수
+ * @remark 남은 공간이 모자라면 장치에 쓰고, 버퍼보다 크면 버퍼를 늘림.
+ *         버퍼는 아주 긴 줄에서만 늘어남
+ */
+void HtmlWriter::reserve(qint64 bytes)
+{
+    if (_end - _out >= bytes)
+        return;
+
+    flush();
+
+    if (bytes > _buffer.size())
+    {
+        _buffer.resize(static_cast<int>(bytes));
+
+        _out = _buffer.data();
+        _end = _out + _buffer.size();
+    }
+}
+
+/**
+ * @brief 버퍼에 쓴 바이트들을 장치에 씀
+ */
+void HtmlWriter::flush()
+{
+    qint64 length = _out - _buffer.constData();
+
+    if (length > 0 && _device->write(_buffer.constData(), length) != length)
+        _ok = false;
+
+    _out = _buffer.data();
+}
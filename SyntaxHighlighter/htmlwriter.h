@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** htmlwriter.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file htmlwriter.h
+ */
+
+#ifndef HTMLWRITER_H
+#define HTMLWRITER_H
+
+#include "tokenlexer.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+
+/**
+ * @brief 문법 강조된 HTML 내보내기 클래스
+ *
+ * 텍스트를 줄마다 TokenLexer 로 분석하여, 문법 강조된 HTML 문서를 UTF-8 로
+ * 장치에 바로 쓴다. 중간에 QString 을 만들지 않고 미리 할당한 버퍼에 쓰며,
+ * 버퍼가 차면 장치에 쓴다. 줄마다 필요한 공간을 한 번에 확보하므로, 문자를
+ * 쓸 때는 버퍼 끝을 확인하지 않는다.
+ *
+ * 이스케이프할 ASCII 문자는 표로 찾으므로, 이스케이프할 필요 없는 문자는
+ * 비교 한 번으로 그대로 버퍼에 옮긴다. 색은 토큰 종류마다 CSS 클래스로
+ * 주고, 여는 태그는 생성할 때 한 번만 만든다. 붙어 있는 같은 종류의 토큰은
+ * 한 태그로 묶는다. 텍스트는 \<pre\> 안에 쓰므로 공백과 줄 바꿈은 바꾸지
+ * 않는다. 언어는 setGrammar() 로 바꾸며, 기본은 C/C++ 이다.
+ *
+ * @code
+ * QFile file("out.html");
+ *
+ * if (file.open(QIODevice::WriteOnly))
+ *     HtmlWriter(&file).write(text, "main.cpp");
+ * @endcode
+ */
+class HtmlWriter
+{
+public:
+    enum
+    {
+        BufferSize = 64 * 1024, /// 출력 버퍼 크기
+        MaxCharBytes = 5,       /// 한 문자를 쓰는 최대 바이트 수. "&amp;"
+        MaxOpenLength = 32      /// 여는 태그의 최대 길이
+    };
+
+    explicit HtmlWriter(QIODevice *device);
+
+    /**
+     * @brief 언어를 바꿈
+     * @param grammar 언어 정의
+     */
+    void setGrammar(const QSharedPointer<const Grammar> &grammar)
+    {
+        _lexer.setGrammar(grammar);
+    }
+
+    bool write(const QString &text, const QString &title = QString());
+
+    static const char *className(TokenMatcher::Kind kind);
+
+private:
+    QIODevice *_device;                 /// 출력 장치
+    TokenLexer _lexer;                  /// 줄 단위 토큰 분석기
+    QVector<TokenLexer::Span> _spans;   /// 색을 칠할 구간들
+    QByteArray _opens[TokenMatcher::KindCount]; /// 토큰 종류마다 여는 태그.
+                                                /// 색이 없으면 비어 있음
+    QByteArray _buffer;                 /// 출력 버퍼
+    char *_out;                         /// 버퍼에서 다음에 쓸 위치
+    char *_end;                         /// 버퍼 끝
+    bool _ok;                           /// 지금까지 장치에 모두 썼는지 여부
+
+    void writeRaw(const char *data, int length);
+
+    /**
+     * @brief 바이트 배열을 그대로 씀
+     * @param data 바이트 배열
+     */
+    void writeRaw(const QByteArray &data)
+    {
+        writeRaw(data.constData(), data.size());
+    }
+
+    void writeEscaped(const QChar *begin, const QChar *end);
+    void writeLine(const QChar *line, int length);
+    void reserve(qint64 bytes);
+    void flush();
+};
+
+#endif // HTMLWRITER_H
@@ -0,0 +1,519 @@
+/****************************************************************************
+**
+** legacyhighlighter.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+
+/** @file legacyhighlighter.cpp
+ */
+
+#include "legacyhighlighter.h"
+#include "tokenparser.h"
+
+#include <QStringList>
+
+/**
+ * @brief 토큰 처리를 위한 추상 클래스
+ */
+class TokenAbstract
+{
+public:
+    enum TokenType {Nothing = 0, Keyword, Block};
+
+    /**
+     * @brief 보통 텍스트를 HTML 텍스트로 바꿈
+     * @param plain 보통 텍스트
+     * @return HTML 텍스트
+     */
+    static QString plainToHtml(const QString &plain)
+    {
+        QString result;
+
+        for (int i = 0; i < plain.length(); ++i)
+        {
+            QChar ch(plain.at(i));
+
+            if (ch == ' ')
+                result.append("&nbsp;");
+            else if (ch == '\n')
+                result.append("<br/>");
+            else if (ch == '<')
+                result.append("&lt;");
+            else if (ch == '>')
+                result.append("&gt;");
+            else if (ch == '&')
+                result.append("&amp;");
+            else
+                result.append(ch);
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief TokenAbstract 생성자
+     * @param token 토큰
+     * @param color 색
+     */
+    TokenAbstract(const QString &token, const QString &color)
+        : _token(token)
+        , _color(color)
+    {
+    }
+
+    /**
+     * @brief TokenAbstract 소멸자
+     */
+    virtual ~TokenAbstract() {}
+
+    /**
+     * @brief 토큰 타입을 얻음
+     * @return 토큰 타입
+     */
+    virtual TokenType type() const = 0;
+
+    /**
+     * @brief 토큰이 일치하는지 확인
+     * @param token 토큰. 일치하는 토큰으로 바뀜
+     * @param parser 토큰 파서
+     * @return 일치하면 true, 아니면 false
+     */
+    virtual bool matched(QString *token, TokenParser *parser) const = 0;
+
+    /**
+     * @brief 현재 토큰을 얻음
+     * @return 현재 토큰
+     */
+    virtual QString token() const
+    {
+        return _token;
+    }
+
+    /**
+     * @brief 토큰의 색을 얻음
+     * @return 토큰의 색
+     */
+    virtual QString color() const
+    {
+        return _color;
+    }
+
+    /**
+     * @brief HTML 텍스트를 얻음
+     * @return HTML 텍스트
+     */
+    virtual QString html() const = 0;
+
+private:
+    QString _token; /// 토큰
+    QString _color; /// 색
+};
+
+/**
+ * @brief 키워드 토큰 클래스
+ */
+class TokenKeyword : public TokenAbstract
+{
+public:
+    /**
+     * @brief TokenKeyword 생성자
+     * @param token 토큰
+     * @param color 색
+     */
+    TokenKeyword(const QString &token, const QString &color)
+        : TokenAbstract(token, color)
+    {
+    }
+
+    bool matched(QString *token, TokenParser *parser) const Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(parser);
+
+        return *token == this->token();
+    }
+
+    QString html() const Q_DECL_OVERRIDE
+    {
+        return QString("<span style=\"color:%1\">").arg(color())
+                .append(plainToHtml(this->token()))
+                .append("</span>");
+    }
+
+    TokenType type() const Q_DECL_OVERRIDE
+    {
+        return Keyword;
+    }
+};
+
+/**
+ * @brief 전처리기 지시자 클래스
+ */
+class TokenDirective : public TokenAbstract
+{
+public:
+    /**
+     * @brief TokenDirective 생성자
+     * @param token 토큰
+     * @param color 색
+     * @param prefix 접두어
+     */
+    TokenDirective(const QString &token, const QString &color,
+                    const QString &prefix = "#")
+        : TokenAbstract(token, color)
+        , _prefix(prefix)
+        , _matched_token(prefix + token)
+    {
+    }
+
+    bool matched(QString *token, TokenParser *parser) const Q_DECL_OVERRIDE
+    {
+        // 파싱 위치 저장
+        int savedPos = parser->currentPos();
+
+        QString prefix(*token);
+
+        // 접두어 확인
+        while (prefix.length() < _prefix.length() &&
+               _prefix.startsWith(prefix) && parser->hasNext())
+            prefix.append(parser->next());
+
+        if (prefix == _prefix)
+        {
+            QString nextToken;
+
+            // 공백문자나 탭문자는 넘어감
+            while (parser->hasNext() &&
+                   ((nextToken = parser->peekNext()) == " " ||
+                    nextToken == "\t"))
+                prefix.append(parser->next());
+
+            QString tkword(TokenAbstract::token());
+            QString word;
+
+            // 단어 확인
+            while (word.length() < tkword.length() &&
+                   tkword.startsWith(word) && parser->hasNext())
+                word.append(parser->next());
+
+            if (word == tkword)
+            {
+                *token = _matched_token = prefix + word;
+
+                return true;
+            }
+        }
+
+        // 파싱 위치 복원
+        parser->setCurrentPos(savedPos);
+
+        return false;
+    }
+
+    QString token() const Q_DECL_OVERRIDE
+    {
+        return _matched_token;
+    }
+
+    QString html() const Q_DECL_OVERRIDE
+    {
+        return QString("<span style=\"color:%1\">").arg(color())
+                .append(plainToHtml(this->token()))
+                .append("</span>");
+    }
+
+    TokenType type() const Q_DECL_OVERRIDE
+    {
+        return Keyword;
+    }
+
+private:
+    QString _prefix;                /// 접두어
+    mutable QString _matched_token; /// 일치한 토큰
+};
+
+/**
+ * @brief 블럭 토큰 클래스
+ */
+class TokenBlock : public TokenAbstract
+{
+public:
+    /**
+     * @brief TokenBlock 생성자
+     * @param token 토큰
+     * @param endToken 끝나는 토큰
+     * @param color 색
+     */
+    TokenBlock(const QString &token, const QString &endToken,
+               const QString &color)
+        : TokenAbstract(token, color)
+        , _startToken(token)
+        , _endToken(endToken)
+        , _started(false)
+    {
+    }
+
+    bool matched(QString *token, TokenParser *parser) const Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(parser);
+
+        QString tkblock(_started ? _endToken : _startToken);
+
+        QString tk(*token);
+
+        // 파싱 위치 저장
+        int savedPos = parser->currentPos();
+
+        // 토큰 확인
+        while (tk.length() < tkblock.length() &&
+               tkblock.startsWith(tk) && parser->hasNext())
+            tk.append(parser->next());
+
+        if (tk == tkblock)
+        {
+            // 토큰 시작 상태 바꿈
+            _started = !_started;
+
+            *token = tk;
+
+            return true;
+        }
+
+        // 파싱 위치 복원
+        parser->setCurrentPos(savedPos);
+
+        return false;
+    }
+
+    QString token() const Q_DECL_OVERRIDE
+    {
+        return _started ? _startToken : _endToken;
+    }
+
+    QString html() const Q_DECL_OVERRIDE
+    {
+        QString tk(plainToHtml(this->token()));
+
+        if (_started)
+            tk.prepend(QString("<span style=\"color:%1;\">").arg(color()));
+        else
+            tk.append("</span>");
+
+        return tk;
+    }
+
+    TokenType type() const Q_DECL_OVERRIDE
+    {
+        return Block;
+    }
+
+    /**
+     * @brief 블럭 내부인지 확인
+     * @return 블럭 내부이면 true, 아니면 false
+     */
+    bool inner() const
+    {
+        return _started;
+    }
+
+    /**
+     * @brief 블럭 내부 상태 해제
+     */
+    void reset()
+    {
+        _started = false;
+    }
+
+private:
+    QString _startToken;    /// 시작 토큰
+    QString _endToken;      /// 끝 토큰
+    mutable bool _started;  /// 시작 상태
+};
+
+/**
+ * @brief LegacyHighlighter 생성자
+ * @remark 토큰 종류들은 예전처럼 블럭, 키워드, 전처리기 지시자, 기호
+ *         순서로 추가함
+ */
+LegacyHighlighter::LegacyHighlighter()
+{
+    // 블럭 토큰 추가
+    _tokenTypes.append(new TokenBlock("\"", "\"", "green"));
+    _tokenTypes.append(new TokenBlock("'", "'", "green"));
+    _tokenTypes.append(new TokenBlock("/*", "*/", "green"));
+    _tokenTypes.append(new TokenBlock("//", "\n", "green"));
+
+    QStringList keywords;
+
+    // 키워드 추가
+    keywords << "asm" << "auto"
+             << "bool" << "break"
+             << "case" << "catch" << "cdecl" << "char" << "class" << "const"
+                << "const_cast" << "continue"
+             << "default" << "delete" << "double" << "do" << "dynamic_cast"
+             << "else" << "enum" << "explicit" << "extern"
+             << "far" << "float" << "for" << "friend"
+             << "goto"
+             << "huge"
+             << "if" << "interrupt" << "int"
+             << "long"
+             << "mutable"
+             << "namespace" << "near" << "new"
+             << "operator"
+             << "pascal" << "private" << "protected" << "public"
+             << "register" << "reinterpret_cast" << "return"
+             << "short" << "signed" << "sizeof" << "static" << "static_cast"
+                << "struct" << "switch"
+             << "template" << "this" << "throw" << "try" << "typedef"
+                << "typename"
+             << "union" << "unsigned" << "using"
+             << "virtual" << "void" << "volatile"
+             << "while"
+             << "yield";
+
+    // 특수 상수 추가
+    keywords << "true" << "false"
+             << "TRUE" << "FALSE"
+             << "NULL";
+
+    foreach (QString keyword, keywords)
+        _tokenTypes.append(new TokenKeyword(keyword, "#808000"));
+
+    // 전처리기 지시자 추가
+    QStringList directives;
+
+    directives  << "define"
+                << "elif" << "else" << "endif" << "error"
+                << "if" << "ifdef" << "ifndef" << "include"
+                << "line"
+                << "pragma"
+                << "undef"
+                << "warning";
+
+    foreach (QString directive, directives)
+        _tokenTypes.append(new TokenDirective(directive, "blue", "#"));
+
+    // 기호 추가
+    QStringList ops;
+
+    ops << ">" << "<" << "{" << "}" << "(" << ")" << "[" << "]" << "+" << "-"
+        << ":" << "&" << "!" << "|" << "=" << "~" << "?" << "." << ";"
+        << "," << "%" << "^" << "/" << "*";
+
+    foreach (QString op, ops)
+        _tokenTypes.append(new TokenKeyword(op, "red"));
+}
+
+/**
+ * @brief LegacyHighlighter 소멸자
+ */
+LegacyHighlighter::~LegacyHighlighter()
+{
+    // 추가된 토큰 해제
+    qDeleteAll(_tokenTypes);
+}
+
+/**
+ * @brief 문법 강조된 HTML 을 만듦
+ * @param text 원본 텍스트
+ * @return QTextEdit::setHtml() 에 넘기던 HTML
+ */
+QString LegacyHighlighter::toHtml(const QString &text)
+{
+    TokenParser parser(text);
+    QString html;
+
+    // 앞의 호출에서 끝나지 않은 블럭 상태 해제
+    foreach (TokenAbstract *tokenType, _tokenTypes)
+    {
+        if (tokenType->type() == TokenAbstract::Block)
+            static_cast<TokenBlock *>(tokenType)->reset();
+    }
+
+    bool escaped = false;           // 탈출 문자 사용 여부
+    TokenBlock *currentBlock = 0;   // 현재 블럭 토큰
+
+    // 파싱
+    while (parser.hasNext())
+    {
+        QString token = parser.next();
+
+        if (!escaped)   // 탈출 문자가 사용되지 않았으면
+        {
+            TokenAbstract *tokenType;
+            bool matched = false;
+
+            // 토큰 확인
+            foreach(tokenType, _tokenTypes)
+            {
+                if (tokenType->matched(&token, &parser))
+                {
+                    matched = true;
+
+                    break;
+                }
+            }
+
+            if (matched) // 토큰 일치하면
+            {
+                if (!currentBlock)  // 블럭 내부가 아니면
+                {
+                    token = tokenType->html();
+
+                    // 블럭 토큰이면 현재 블럭 토큰 설정
+                    if (tokenType->type() == TokenAbstract::Block)
+                        currentBlock = static_cast<TokenBlock *>(tokenType);
+                }
+                else    // 블럭 내부이면
+                {
+                    // 또다른 블럭이면 블럭 시작 상태 해제
+                    if (tokenType->type() == TokenAbstract::Block &&
+                            tokenType != currentBlock)
+                        static_cast<TokenBlock *>(tokenType)->reset();
+
+                    // 현재 블럭이 끝났으면
+                    if (currentBlock == tokenType && !currentBlock->inner())
+                    {
+                        token = tokenType->html();
+
+                        // 현재 블럭 토큰 없음
+                        currentBlock = 0;
+                    }
+                    else
+                        token = TokenAbstract::plainToHtml(token);
+                }
+            }
+            else
+                token = TokenAbstract::plainToHtml(token);
+        }
+
+        // 토큰 추가
+        html.append(token);
+
+        // 탈출 문자 ?
+        escaped = !escaped && token == "\\";
+    }
+
+    // HTML 전체 글꼴 설정
+    html.prepend("<div style=\"font-family:Courier New;font-size:10pt;\">");
+    html.append("</div>");
+
+    return html;
+}
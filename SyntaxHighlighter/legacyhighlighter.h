@@ -0,0 +1,60 @@
+/****************************************************************************
+**
+** legacyhighlighter.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+
+/** @file legacyhighlighter.h
+ */
+
+#ifndef LEGACYHIGHLIGHTER_H
+#define LEGACYHIGHLIGHTER_H
+
+#include <QList>
+#include <QString>
+
+class TokenAbstract;
+
+/**
+ * @brief 예전 문법 강조기 클래스
+ *
+ * 처음의 MainWindow::syntaxHighlight() 를 창 없이 그대로 옮긴 것이다.
+ * TokenParser 로 전체 텍스트를 토큰으로 나누고, 토큰마다 모든 토큰
+ * 종류(TokenAbstract)와 차례로 비교하여 HTML 문자열을 만든다.
+ *
+ * 새 분석기와 성능을 비교하기 위해서만 남겨 두었으며, 프로그램은 쓰지
+ * 않는다.
+ */
+class LegacyHighlighter
+{
+public:
+    LegacyHighlighter();
+    ~LegacyHighlighter();
+
+    QString toHtml(const QString &text);
+
+private:
+    QList<TokenAbstract *> _tokenTypes; /// 토큰 종류들
+
+    Q_DISABLE_COPY(LegacyHighlighter)
+};
+
+#endif // LEGACYHIGHLIGHTER_H
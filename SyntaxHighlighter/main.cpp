@@ -21,10 +21,19 @@
 ****************************************************************************/
 
 #include "mainwindow.h"
+#include "highlightercli.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // 명령행 모드는 창 없이 실행
+    if (HighlighterCli::isRequested(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+
+        return HighlighterCli().exec(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
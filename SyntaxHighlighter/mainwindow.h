@@ -30,6 +30,9 @@
 
 #include <QtWidgets>
 
+class Grammar;
+class Highlighter;
+
 /**
  * @brief SyntaxHighliter 클래스
  */
@@ -45,6 +48,8 @@ private:
     QTextEdit *_plainText;          /// 원본 텍스트
     QTextEdit *_syntaxText;         /// 문법 강조된 텍스트
     QPushButton *_highlightButton;  /// 문법 강조 실행 버튼
+    Highlighter *_highlighter;      /// 문법 강조기
+    QSharedPointer<const Grammar> _grammar; /// 선택한 언어 정의
 
     void initMenus();
     void initWidgets();
@@ -52,7 +57,11 @@ private:
 
 private slots:
     void plainTextChanged();
+    void plainContentsChange(int position, int charsRemoved, int charsAdded);
     void syntaxHighlight();
+    void syntaxScrolled();
+    void exportHtml();
+    void languageSelected(QAction *action);
 };
 
 #endif // MAINWINDOW_H
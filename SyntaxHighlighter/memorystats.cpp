@@ -0,0 +1,165 @@
+/****************************************************************************
+**
+** memorystats.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+
+/** @file memorystats.cpp
+ */
+
+#include "memorystats.h"
+
+#include <QAtomicInteger>
+#include <QFile>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+// 할당 횟수는 CONFIG+=allocation_stats 로 빌드했고 glibc 일 때만 셈
+#if defined(SH_COUNT_ALLOCATIONS) && defined(__GLIBC__)
+#define COUNT_ALLOCATIONS
+#endif
+
+#if defined(COUNT_ALLOCATIONS)
+#include <cstddef>
+
+/// 지금까지 할당한 횟수
+static QAtomicInteger<quint64> allocationCount;
+
+extern "C" {
+
+void *__libc_malloc(size_t size) __THROW;
+void *__libc_calloc(size_t count, size_t size) __THROW;
+void *__libc_realloc(void *ptr, size_t size) __THROW;
+
+/**
+ * @brief 할당 횟수를 세고 glibc 의 malloc() 으로 넘김
+ */
+void *malloc(size_t size) __THROW
+{
+    allocationCount.fetchAndAddRelaxed(1);
+
+    return __libc_malloc(size);
+}
+
+/**
+ * @brief 할당 횟수를 세고 glibc 의 calloc() 으로 넘김
+ */
+void *calloc(size_t count, size_t size) __THROW
+{
+    allocationCount.fetchAndAddRelaxed(1);
+
+    return __libc_calloc(count, size);
+}
+
+/**
+ * @brief 할당 횟수를 세고 glibc 의 realloc() 으로 넘김
+ */
+void *realloc(void *ptr, size_t size) __THROW
+{
+    allocationCount.fetchAndAddRelaxed(1);
+
+    return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+#endif
+
+/**
+ * @brief 할당 횟수를 세는지 알려줌
+ * @return 세면 true, 아니면 false
+ */
+bool MemoryStats::countsAllocations()
+{
+#if defined(COUNT_ALLOCATIONS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 지금까지의 할당 횟수를 얻음
+ * @return malloc(), calloc(), realloc() 을 부른 횟수. 세지 않으면 0
+ * @remark 구간 앞뒤의 차이로 구간의 할당 횟수를 얻음
+ */
+quint64 MemoryStats::allocations()
+{
+#if defined(COUNT_ALLOCATIONS)
+    return allocationCount.loadAcquire();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief 최대 RSS 를 지금 RSS 로 되돌림
+ * @remark 리눅스 4.0 이상에서만 됨. 안 되면 프로세스 전체의 최댓값이 남음
+ */
+void MemoryStats::resetPeakRss()
+{
+#if defined(Q_OS_LINUX)
+    QFile file("/proc/self/clear_refs");
+
+    if (file.open(QIODevice::WriteOnly))
+        file.write("5");
+#endif
+}
+
+/**
+ * @brief 최대 RSS 를 얻음
+ * @return 바이트 수. 알 수 없으면 -1
+ */
+qint64 MemoryStats::peakRss()
+{
+#if defined(Q_OS_LINUX)
+    QFile file("/proc/self/status");
+
+    // /proc 파일은 크기가 0 이므로 줄 단위로 읽음
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        while (!file.atEnd())
+        {
+            QByteArray line = file.readLine();
+
+            if (line.startsWith("VmHWM:"))
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong()
+                        * 1024;
+        }
+    }
+#endif
+
+#if defined(Q_OS_UNIX)
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#if defined(Q_OS_MAC)
+        return usage.ru_maxrss;         // 바이트
+#else
+        return usage.ru_maxrss * 1024;  // KB
+#endif
+    }
+#endif
+
+    return -1;
+}
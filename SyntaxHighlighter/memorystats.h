@@ -0,0 +1,58 @@
+/****************************************************************************
+**
+** memorystats.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+
+/** @file memorystats.h
+ */
+
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <QtGlobal>
+
+/**
+ * @brief 메모리 사용 통계 클래스
+ *
+ * 성능을 잴 때 메모리 할당 횟수와 최대 상주 메모리(RSS)를 얻는다.
+ *
+ * 할당 횟수는 CONFIG+=allocation_stats 로 빌드한 glibc 프로그램에서만
+ * 센다. Qt 컨테이너는 operator new 가 아니라 malloc() 으로 할당하므로,
+ * 실행 파일에서 malloc(), calloc(), realloc() 을 가로채 glibc 의 할당자로
+ * 넘기면서 센다. 가로채면 모든 할당이 느려지고 다른 할당자나 새니타이저와
+ * 함께 쓸 수 없으므로, 성능을 잴 때만 켠다. 켜지 않으면 세지 않는다.
+ *
+ * 최대 RSS 는 리눅스에서 /proc/self/status 의 VmHWM 으로 얻고,
+ * /proc/self/clear_refs 로 지금 RSS 까지 되돌려 구간마다 잰다. 다른
+ * 유닉스에서는 getrusage() 로 프로세스 전체의 최댓값만 얻는다.
+ */
+class MemoryStats
+{
+public:
+    static bool countsAllocations();
+    static quint64 allocations();
+
+    static void resetPeakRss();
+    static qint64 peakRss();
+};
+
+#endif // MEMORYSTATS_H
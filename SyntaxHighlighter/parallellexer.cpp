@@ -0,0 +1,283 @@
+/****************************************************************************
+**
+** parallellexer.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file parallellexer.cpp
+ */
+
+#include "parallellexer.h"
+
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief 한 시작 상태에서 분석한 결과
+ */
+struct Run
+{
+    QVector<TokenLexer::Span> spans;    /// 색을 칠할 구간들
+    QVector<int> spanEnds;              /// 줄마다 마지막 구간 다음 번호
+    QVector<TokenLexer::State> states;  /// 줄마다 끝날 때의 상태
+};
+
+/**
+ * @brief 텍스트 조각
+ */
+struct Chunk
+{
+    int start;                  /// 시작 위치. 줄의 시작
+    int end;                    /// 끝 위치. 마지막 줄 끝의 줄 바꿈 다음
+    QVector<int> lineStarts;    /// 줄마다 시작 위치
+    QVector<Run> runs;          /// 시작 상태마다 분석한 결과. 블럭 밖
+                                /// 이외에는 블럭 밖에서 시작한 결과와
+                                /// 같아진 줄까지만 가짐
+    TokenLexer::State entry;    /// 이어 붙일 때 정해진 시작 상태
+    int lineOffset;             /// 이어 붙인 결과에서 첫 줄 번호
+    int spanOffset;             /// 이어 붙인 결과에서 첫 구간 번호
+};
+
+/**
+ * @brief 조각을 가능한 모든 시작 상태로 분석함
+ * @param lexer 줄 단위 토큰 분석기
+ * @param text 전체 텍스트
+ * @param chunk 분석할 조각
+ * @param cancel 0 이 아니게 되면 분석을 멈춤. 0 이면 멈추지 않음
+ * @param withSpans true 이면 구간도 모으고, false 이면 줄의 상태만 모음
+ * @remark 첫 조각은 블럭 밖에서만 시작하므로 다른 상태로 분석하지 않음
+ */
+void lexChunk(const TokenLexer &lexer, const QString &text, Chunk *chunk,
+              const QAtomicInt *cancel, bool withSpans)
+{
+    QStringView view(text);
+    Run &normal = chunk->runs[TokenLexer::Normal];
+    TokenLexer::State state = TokenLexer::Normal;
+
+    // 구간을 모으지 않을 때 줄마다 비워 쓰는 구간 배열
+    QVector<TokenLexer::Span> scratch;
+    QVector<TokenLexer::Span> *spans = withSpans ? &normal.spans : &scratch;
+
+    // 기준. 블럭 밖에서 시작
+    for (int pos = chunk->start; pos < chunk->end; )
+    {
+        if (cancel && cancel->load())
+            return;
+
+        int eol = text.indexOf('\n', pos);
+
+        if (eol < 0)
+            eol = text.length();
+
+        chunk->lineStarts.append(pos);
+
+        scratch.clear();
+
+        state = lexer.lexLine(view.mid(pos, eol - pos), state, spans);
+
+        normal.spanEnds.append(normal.spans.size());
+        normal.states.append(state);
+
+        pos = eol + 1;
+    }
+
+    if (chunk->start == 0)
+        return;
+
+    const int lines = chunk->lineStarts.size();
+
+    // 블럭 안에서 시작하는 추측 분석
+    for (int s = TokenLexer::Normal + 1; s < chunk->runs.size(); ++s)
+    {
+        Run &run = chunk->runs[s];
+
+        spans = withSpans ? &run.spans : &scratch;
+        state = static_cast<TokenLexer::State>(s);
+
+        for (int line = 0; line < lines; ++line)
+        {
+            if (cancel && cancel->load())
+                return;
+
+            int start = chunk->lineStarts.at(line);
+            int end = line + 1 < lines
+                    ? chunk->lineStarts.at(line + 1) : chunk->end;
+
+            scratch.clear();
+
+            // end - 1 은 줄 바꿈이거나 텍스트 끝
+            state = lexer.lexLine(view.mid(start, end - 1 - start), state,
+                                  spans);
+
+            run.spanEnds.append(run.spans.size());
+            run.states.append(state);
+
+            // 기준과 상태가 같아지면 나머지 줄은 기준과 같음
+            if (state == normal.states.at(line))
+                break;
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @brief ParallelLexer 생성자
+ * @param grammar 언어 정의
+ */
+ParallelLexer::ParallelLexer(const QSharedPointer<const Grammar> &grammar)
+    : _lexer(grammar)
+    , _spansEnabled(true)
+{
+}
+
+/**
+ * @brief 텍스트를 여러 스레드에서 분석함
+ * @param text 분석할 텍스트
+ * @param cancel 다른 스레드에서 0 이 아니게 바꾸면 분석을 멈춤. 0 이면
+ *               멈추지 않음
+ * @return 줄마다 분석한 결과. 줄은 \n 으로 나눔. 멈추었으면 빈 결과.
+ *         구간을 돌려주지 않도록 설정했으면 구간은 비어 있음
+ * @remark 한 스레드에서 처음부터 차례로 분석한 결과와 같음
+ */
+LexedText ParallelLexer::lex(const QString &text,
+                             const QAtomicInt *cancel) const
+{
+    const int length = text.length();
+
+    // 스레드마다 몇 조각씩 돌아가도록 나눔
+    const int chunkLength =
+            qMax<int>(MinChunkLength,
+                      length / (QThread::idealThreadCount() * 4) + 1);
+
+    QVector<Chunk> chunks;
+
+    // 줄 바꿈 다음에서 나눔. 마지막 조각은 텍스트 끝에 줄 바꿈이 있는
+    // 것처럼 끝 위치를 하나 늘림
+    for (int start = 0; start <= length; )
+    {
+        Chunk chunk;
+        int eol = start + chunkLength < length
+                ? text.indexOf('\n', start + chunkLength) : -1;
+
+        chunk.start = start;
+        chunk.end = eol < 0 ? length + 1 : eol + 1;
+        chunk.runs.resize(_lexer.stateCount());
+
+        chunks.append(chunk);
+
+        start = chunk.end;
+    }
+
+    // 1 단계: 조각마다 가능한 모든 시작 상태로 분석
+    QtConcurrent::blockingMap(chunks, [this, &text, cancel](Chunk &chunk)
+    {
+        lexChunk(_lexer, text, &chunk, cancel, _spansEnabled);
+    });
+
+    if (cancel && cancel->load())
+        return LexedText();
+
+    // 2 단계: 앞 조각의 끝 상태로 다음 조각의 시작 상태를 고름
+    TokenLexer::State state = TokenLexer::Normal;
+    int lineCount = 0;
+    int spanCount = 0;
+
+    for (int i = 0; i < chunks.size(); ++i)
+    {
+        Chunk &chunk = chunks[i];
+        const Run &normal = chunk.runs[TokenLexer::Normal];
+        const Run &run = chunk.runs[state];
+
+        // 시작 상태로 분석한 줄 수. 나머지는 기준과 같음
+        int own = run.states.size();
+        int ownSpans = own ? run.spanEnds.at(own - 1) : 0;
+        int normalSpans = own ? normal.spanEnds.at(own - 1) : 0;
+
+        chunk.entry = state;
+        chunk.lineOffset = lineCount;
+        chunk.spanOffset = spanCount;
+
+        lineCount += chunk.lineStarts.size();
+        spanCount += ownSpans + normal.spans.size() - normalSpans;
+
+        state = own == chunk.lineStarts.size() ? run.states.last()
+                                               : normal.states.last();
+    }
+
+    LexedText lexed;
+
+    lexed.text = text;
+    lexed.lineStarts.resize(lineCount);
+    lexed.spanStarts.resize(lineCount + 1);
+    lexed.spans.resize(spanCount);
+    lexed.states.resize(lineCount);
+
+    lexed.spanStarts[lineCount] = spanCount;
+
+    // 스레드에서 분리(detach) 검사를 하지 않도록 미리 포인터를 얻음
+    int *lineStarts = lexed.lineStarts.data();
+    int *spanStarts = lexed.spanStarts.data();
+    TokenLexer::Span *spans = lexed.spans.data();
+    TokenLexer::State *states = lexed.states.data();
+
+    // 3 단계: 고른 결과를 제자리에 복사
+    QtConcurrent::blockingMap(chunks, [=](const Chunk &chunk)
+    {
+        const Run &normal = chunk.runs[TokenLexer::Normal];
+        const Run &run = chunk.runs[chunk.entry];
+        const int lines = chunk.lineStarts.size();
+
+        int own = run.states.size();
+        int ownSpans = own ? run.spanEnds.at(own - 1) : 0;
+        int normalSpans = own ? normal.spanEnds.at(own - 1) : 0;
+
+        TokenLexer::Span *out = std::copy(run.spans.constBegin(),
+                                          run.spans.constBegin() + ownSpans,
+                                          spans + chunk.spanOffset);
+
+        std::copy(normal.spans.constBegin() + normalSpans,
+                  normal.spans.constEnd(), out);
+
+        for (int line = 0; line < lines; ++line)
+        {
+            int index = chunk.lineOffset + line;
+            int first;
+
+            if (line == 0)
+                first = 0;
+            else if (line <= own)
+                first = run.spanEnds.at(line - 1);
+            else
+                first = ownSpans + normal.spanEnds.at(line - 1) - normalSpans;
+
+            lineStarts[index] = chunk.lineStarts.at(line);
+            spanStarts[index] = chunk.spanOffset + first;
+            states[index] = line < own ? run.states.at(line)
+                                       : normal.states.at(line);
+        }
+    });
+
+    return lexed;
+}
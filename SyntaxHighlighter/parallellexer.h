@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** parallellexer.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file parallellexer.h
+ */
+
+#ifndef PARALLELLEXER_H
+#define PARALLELLEXER_H
+
+#include "tokenlexer.h"
+
+#include <QAtomicInt>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 미리 분석한 텍스트
+ *
+ * 줄마다 시작 위치, 색을 칠할 구간, 줄이 끝날 때의 상태를 가진다. 줄
+ * i 의 구간은 spans[spanStarts[i]] 부터 spans[spanStarts[i + 1]] 앞까지이고,
+ * 구간의 위치는 줄의 시작에서 센다.
+ */
+struct LexedText
+{
+    QString text;                       /// 분석한 텍스트
+    QVector<int> lineStarts;            /// 줄마다 시작 위치
+    QVector<int> spanStarts;            /// 줄마다 첫 구간 번호. 줄 수 + 1 개
+    QVector<TokenLexer::Span> spans;    /// 색을 칠할 구간들
+    QVector<TokenLexer::State> states;  /// 줄마다 끝날 때의 상태
+};
+
+/**
+ * @brief 병렬 토큰 분석기 클래스
+ *
+ * 텍스트를 줄 경계에서 조각으로 나누어 스레드 풀에서 동시에 분석한다.
+ * 조각이 시작할 때의 상태는 앞 조각을 다 분석해야 알 수 있으므로, 조각마다
+ * 가능한 모든 시작 상태로 미리 분석해 둔다. 그런 다음 첫 조각부터 차례로
+ * 앞 조각의 끝 상태로 다음 조각의 시작 상태를 골라 이어 붙인다.
+ *
+ * 블럭 밖에서 시작한 분석을 기준으로, 다른 상태에서 시작한 분석은 줄이 끝날
+ * 때의 상태가 기준과 같아지면 멈춘다. 그 뒤로는 기준과 결과가 같기
+ * 때문이다. 블럭은 대개 몇 줄 안에 끝나므로, 추측 분석에 드는 시간은
+ * 기준 분석보다 훨씬 짧다. 시작 상태 수는 언어 정의의 블럭 수 + 1 이다.
+ *
+ * 분석기는 상태를 바꾸지 않으므로, 복사본을 다른 스레드에 넘길 수 있다.
+ */
+class ParallelLexer
+{
+public:
+    enum { MinChunkLength = 256 * 1024 };   /// 조각의 최소 문자 수
+
+    explicit ParallelLexer(const QSharedPointer<const Grammar> &grammar
+                                = Grammar::builtin());
+
+    /**
+     * @brief 언어 정의를 바꿈
+     * @param grammar 언어 정의
+     */
+    void setGrammar(const QSharedPointer<const Grammar> &grammar)
+    {
+        _lexer.setGrammar(grammar);
+    }
+
+    /**
+     * @brief 색을 칠할 구간도 돌려줄지 설정
+     * @param enabled true 이면 구간도 돌려주고, false 이면 줄의 상태만 돌려줌
+     */
+    void setSpansEnabled(bool enabled)
+    {
+        _spansEnabled = enabled;
+    }
+
+    /**
+     * @brief 색을 칠할 구간도 돌려주는지 알려줌
+     * @return 돌려주면 true, 아니면 false
+     */
+    bool spansEnabled() const
+    {
+        return _spansEnabled;
+    }
+
+    LexedText lex(const QString &text, const QAtomicInt *cancel = 0) const;
+
+private:
+    TokenLexer _lexer;  /// 줄 단위 토큰 분석기. 모든 스레드가 함께 씀
+    bool _spansEnabled; /// 색을 칠할 구간도 돌려주는지 여부
+};
+
+#endif // PARALLELLEXER_H
@@ -0,0 +1,191 @@
+/****************************************************************************
+**
+** tokenlexer.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file tokenlexer.cpp
+ */
+
+#include "tokenlexer.h"
+
+/**
+ * @brief TokenLexer 생성자
+ * @param grammar 언어 정의
+ */
+TokenLexer::TokenLexer(const QSharedPointer<const Grammar> &grammar)
+    : _matcher(grammar)
+{
+}
+
+/**
+ * @brief 한 줄을 분석함
+ * @param line 줄 바꿈 문자를 뺀 한 줄
+ * @param state 줄이 시작할 때의 상태
+ * @param spans 색을 칠할 구간들이 더해짐
+ * @return 줄이 끝날 때의 상태
+ * @remark 블럭 내부에서는 블럭이 끝나는 토큰만 찾음. 끝 토큰이 없는
+ *         블럭은 줄 끝에서 끝나지만, 언어가 허용하면 줄 끝의 탈출 문자로
+ *         다음 줄에 이어짐
+ */
+TokenLexer::State TokenLexer::lexLine(QStringView line, State state,
+                                      QVector<Span> *spans) const
+{
+    const int length = line.size();
+    const int escapeChar = _matcher.escapeChar();
+
+    int pos = 0;
+    int blockStart = 0;     // 현재 블럭의 시작 위치
+    bool escaped = false;   // 탈출 문자 사용 여부
+
+    while (pos < length)
+    {
+        if (state != Normal)    // 블럭 내부이면
+        {
+            // 끝나는 토큰까지 건너뜀. 블럭 안의 낱말에는 끝나는 토큰이
+            // 없으므로, 탈출 문자 다음은 한 문자만 건너뛰면 됨
+            const int block = state - 1;
+            const QStringView end = _matcher.blockEnd(block);
+            const int first = end.isEmpty() ? -1 : end.at(0).unicode();
+            bool closed = false;
+
+            for (; pos < length; ++pos)
+            {
+                ushort ch = line.at(pos).unicode();
+
+                if (escaped)
+                    escaped = false;
+                else if (ch == escapeChar)
+                    escaped = true;
+                else if (ch == first && line.mid(pos).startsWith(end))
+                {
+                    pos += end.size();
+                    closed = true;
+
+                    break;
+                }
+            }
+
+            if (closed)
+            {
+                Span span = {blockStart, pos - blockStart,
+                             _matcher.blockKind(block)};
+
+                spans->append(span);
+
+                state = Normal;
+            }
+
+            continue;
+        }
+
+        TokenMatcher::CharClass charClass = _matcher.charClass(line.at(pos));
+
+        // 탈출 문자 다음 토큰은 건너뜀
+        if (escaped)
+        {
+            pos += charClass == TokenMatcher::WordChar
+                    ? _matcher.wordLength(line, pos) : 1;
+            escaped = false;
+
+            continue;
+        }
+
+        switch (charClass)
+        {
+        case TokenMatcher::WordChar:
+        {
+            int n = _matcher.wordLength(line, pos);
+
+            if (_matcher.isKeyword(line.mid(pos, n)))
+            {
+                Span span = {pos, n, TokenMatcher::Keyword};
+
+                spans->append(span);
+            }
+
+            pos += n;
+            break;
+        }
+
+        case TokenMatcher::EscapeChar:
+            escaped = true;
+            ++pos;
+            break;
+
+        case TokenMatcher::SymbolChar:
+        {
+            TokenMatcher::Kind kind;
+            int block;
+            int n = qMax(_matcher.matchSymbol(line.mid(pos), &kind, &block),
+                         1);
+
+            if (kind == TokenMatcher::Operator)
+            {
+                Span span = {pos, n, kind};
+
+                spans->append(span);
+            }
+            else if (kind == TokenMatcher::DirectivePrefix)
+            {
+                int end = _matcher.matchDirective(line, pos + n);
+
+                if (end >= 0)
+                {
+                    Span span = {pos, end - pos, TokenMatcher::Directive};
+
+                    spans->append(span);
+
+                    n = end - pos;
+                }
+            }
+            else if (block >= 0)    // 블럭 시작이면
+            {
+                state = static_cast<State>(block + 1);
+                blockStart = pos;
+            }
+
+            pos += n;
+            break;
+        }
+
+        default:
+            ++pos;
+            break;
+        }
+    }
+
+    // 블럭이 끝나지 않았으면 줄 끝까지 칠함
+    if (state != Normal && length > blockStart)
+    {
+        Span span = {blockStart, length - blockStart,
+                     _matcher.blockKind(state - 1)};
+
+        spans->append(span);
+    }
+
+    // 끝 토큰이 없는 블럭은 줄 바꿈 문자가 탈출 문자로 쓰이지 않았으면
+    // 끝나고, 나머지 블럭은 다음 줄로 넘어감
+    if (state != Normal && _matcher.blockEnd(state - 1).isEmpty()
+            && !(escaped && _matcher.lineContinuation()))
+        return Normal;
+
+    return state;
+}
@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** tokenlexer.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file tokenlexer.h
+ */
+
+#ifndef TOKENLEXER_H
+#define TOKENLEXER_H
+
+#include "tokenmatcher.h"
+
+#include <QStringView>
+#include <QVector>
+
+/**
+ * @brief 줄 단위 토큰 분석기 클래스
+ *
+ * 한 줄씩 토큰을 분석하여 색을 칠할 구간을 찾는다. 여러 줄에 걸치는
+ * 블럭은 줄이 끝날 때의 상태로 다음 줄에 넘긴다. 줄의 상태만 알면 그
+ * 줄만 다시 분석할 수 있으므로, 고친 줄과 상태가 바뀐 줄만 다시 분석하면
+ * 된다.
+ *
+ * 토큰은 TokenMatcher 의 표로 분류하므로, 토큰 종류 수와 관계없이 토큰
+ * 길이만큼의 시간에 분류된다. 줄은 QStringView 로 받아 되돌아가지 않고 한
+ * 번만 읽으며, 구간은 (위치, 길이, 종류) 로만 돌려주므로 토큰마다 메모리를
+ * 할당하지 않는다.
+ *
+ * 블럭 안의 상태는 언어 정의의 블럭 번호로 정해지므로, 상태 수는 언어마다
+ * 다르다.
+ */
+class TokenLexer
+{
+public:
+    /**
+     * @brief 줄이 시작하거나 끝날 때의 상태
+     */
+    enum State
+    {
+        Normal = 0,     /// 블럭 밖. 블럭 안이면 블럭 번호 + 1
+        MaxState = Grammar::MaxBlocks   /// 가장 큰 상태
+    };
+
+    /**
+     * @brief 색을 칠할 구간
+     */
+    struct Span
+    {
+        int start;                  /// 시작 위치
+        int length;                 /// 길이
+        TokenMatcher::Kind kind;    /// 토큰 종류. 블럭은 시작 토큰의 종류
+    };
+
+    explicit TokenLexer(const QSharedPointer<const Grammar> &grammar
+                                = Grammar::builtin());
+
+    /**
+     * @brief 언어 정의를 바꿈
+     * @param grammar 언어 정의
+     */
+    void setGrammar(const QSharedPointer<const Grammar> &grammar)
+    {
+        _matcher = TokenMatcher(grammar);
+    }
+
+    /**
+     * @brief 언어 정의를 얻음
+     * @return 언어 정의
+     */
+    const QSharedPointer<const Grammar> &grammar() const
+    {
+        return _matcher.grammar();
+    }
+
+    /**
+     * @brief 상태 수를 얻음
+     * @return 블럭 밖을 포함한 상태 수
+     */
+    int stateCount() const
+    {
+        return _matcher.blockCount() + 1;
+    }
+
+    State lexLine(QStringView line, State state, QVector<Span> *spans) const;
+
+private:
+    TokenMatcher _matcher;  /// 토큰 분류기
+};
+
+#endif // TOKENLEXER_H
@@ -0,0 +1,178 @@
+/****************************************************************************
+**
+** tokenmatcher.cpp
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file tokenmatcher.cpp
+ */
+
+#include "tokenmatcher.h"
+
+/**
+ * @brief TokenMatcher 생성자
+ * @param grammar 언어 정의
+ */
+TokenMatcher::TokenMatcher(const QSharedPointer<const Grammar> &grammar)
+    : _grammar(grammar)
+{
+    const Grammar::Header &header = grammar->header();
+
+    _classes = grammar->at<uchar>(header.classesOffset);
+    _roots = grammar->at<qint32>(header.rootsOffset);
+    _nodes = grammar->at<Grammar::Node>(header.nodesOffset);
+    _keywords = grammar->at<Grammar::Slot>(header.keywordsOffset);
+    _directives = grammar->at<Grammar::Slot>(header.directivesOffset);
+    _blocks = grammar->at<Grammar::Block>(header.blocksOffset);
+    _strings = grammar->at<QChar>(header.stringsOffset);
+
+    _keywordMask = header.keywordSlots - 1;
+    _directiveMask = header.directiveSlots - 1;
+    _blockCount = header.blockCount;
+    _escapeChar = header.escapeChar;
+    _caseSensitive = header.flags & Grammar::CaseSensitive;
+    _lineContinuation = header.flags & Grammar::LineContinuation;
+}
+
+/**
+ * @brief 텍스트의 시작에서 가장 길게 일치하는 기호를 찾음
+ * @param text 텍스트
+ * @param kind 일치한 토큰의 종류를 돌려받음
+ * @param block 블럭 시작이면 블럭 번호, 아니면 -1 을 돌려받음. 0 이면
+ *              돌려받지 않음
+ * @return 일치한 길이. 일치하지 않으면 0
+ */
+int TokenMatcher::matchSymbol(QStringView text, Kind *kind, int *block) const
+{
+    *kind = None;
+
+    if (block)
+        *block = -1;
+
+    if (text.isEmpty() || text.at(0).unicode() >= 128)
+        return 0;
+
+    int node = _roots[text.at(0).unicode()];
+    int length = 0;
+
+    for (int i = 1; node >= 0; ++i)
+    {
+        if (_nodes[node].kind != None)
+        {
+            *kind = static_cast<Kind>(_nodes[node].kind);
+            length = i;
+
+            if (block)
+                *block = _nodes[node].block;
+        }
+
+        if (i >= text.size())
+            break;
+
+        // 다음 문자의 자식 노드 찾음
+        ushort ch = text.at(i).unicode();
+
+        for (node = _nodes[node].child;
+             node >= 0 && _nodes[node].ch != ch;
+             node = _nodes[node].sibling)
+            ;
+    }
+
+    return length;
+}
+
+/**
+ * @brief 접두어 다음의 전처리기 지시자를 찾음
+ * @param text 텍스트
+ * @param pos 접두어 다음 위치
+ * @return 일치하면 지시자가 끝나는 위치, 아니면 -1
+ * @remark 접두어와 지시자 사이의 공백문자와 탭문자는 넘어감
+ */
+int TokenMatcher::matchDirective(QStringView text, int pos) const
+{
+    // 공백문자나 탭문자는 넘어감
+    while (pos < text.size() && (text.at(pos) == ' ' || text.at(pos) == '\t'))
+        ++pos;
+
+    int length = wordLength(text, pos);
+
+    if (length > 0 && isDirective(text.mid(pos, length)))
+        return pos + length;
+
+    return -1;
+}
+
+/**
+ * @brief 낱말의 길이를 얻음
+ * @param text 텍스트
+ * @param pos 낱말이 시작하는 위치
+ * @return 연속된 문자, 숫자, _ 의 수
+ */
+int TokenMatcher::wordLength(QStringView text, int pos) const
+{
+    int end = pos;
+
+    while (end < text.size() && charClass(text.at(end)) == WordChar)
+        ++end;
+
+    return end - pos;
+}
+
+/**
+ * @brief 낱말이 해시 표에 있는지 확인
+ * @param table 해시 표
+ * @param mask 해시 표 크기 - 1
+ * @param word 낱말
+ * @return 있으면 true, 아니면 false
+ * @remark 대소문자를 가리지 않으면 표의 낱말은 소문자이므로 ASCII 대문자만
+ *         소문자로 바꾸어 비교함
+ */
+bool TokenMatcher::contains(const Grammar::Slot *table, quint32 mask,
+                            QStringView word) const
+{
+    const bool fold = !_caseSensitive;
+    const quint32 h = Grammar::hash(word, fold);
+    const int length = word.size();
+
+    for (quint32 i = h & mask; table[i].length > 0; i = (i + 1) & mask)
+    {
+        if (table[i].hash != h || int(table[i].length) != length)
+            continue;
+
+        const QChar *s = _strings + table[i].offset;
+        int j = 0;
+
+        for (; j < length; ++j)
+        {
+            ushort ch = word.at(j).unicode();
+
+            if (fold && ch >= 'A' && ch <= 'Z')
+                ch += 'a' - 'A';
+
+            if (s[j].unicode() != ch)
+                break;
+        }
+
+        if (j == length)
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,195 @@
+/****************************************************************************
+**
+** tokenmatcher.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file tokenmatcher.h
+ */
+
+#ifndef TOKENMATCHER_H
+#define TOKENMATCHER_H
+
+#include "grammar.h"
+
+#include <QSharedPointer>
+#include <QStringView>
+
+/**
+ * @brief 토큰 분류기 클래스
+ *
+ * 키워드와 전처리기 지시자는 해시 표로, 기호와 블럭 구분자, 지시자
+ * 접두어는 문자 트라이로 찾는다. ASCII 문자는 문자 종류 표로 분류한다.
+ * 표는 Grammar 의 이미지를 그대로 가리키므로, 토큰 하나를 분류하는 데는
+ * 토큰 길이만큼의 시간만 걸린다.
+ */
+class TokenMatcher
+{
+public:
+    /**
+     * @brief 토큰 종류
+     */
+    enum Kind
+    {
+        None = 0,           /// 일치하는 토큰 없음
+        Keyword,            /// 키워드
+        Directive,          /// 전처리기 지시자
+        Operator,           /// 기호
+        String,             /// 문자열 시작
+        Char,               /// 문자 상수 시작
+        Comment,            /// 블럭 주석 시작
+        LineComment,        /// 한 줄 주석 시작
+        DirectivePrefix,    /// 전처리기 지시자 접두어
+        KindCount           /// 토큰 종류 수
+    };
+
+    /**
+     * @brief 문자 종류
+     */
+    enum CharClass
+    {
+        OtherChar = 0,  /// 그 밖의 문자. 한 문자가 하나의 토큰
+        WordChar,       /// 문자, 숫자, _. 연속되면 하나의 토큰
+        SymbolChar,     /// 기호나 블럭 구분자의 첫 문자
+        EscapeChar      /// 탈출 문자
+    };
+
+    explicit TokenMatcher(const QSharedPointer<const Grammar> &grammar
+                                = Grammar::builtin());
+
+    /**
+     * @brief 언어 정의를 얻음
+     * @return 언어 정의
+     */
+    const QSharedPointer<const Grammar> &grammar() const
+    {
+        return _grammar;
+    }
+
+    /**
+     * @brief 키워드인지 확인
+     * @param word 낱말
+     * @return 키워드이면 true, 아니면 false
+     */
+    bool isKeyword(QStringView word) const
+    {
+        return contains(_keywords, _keywordMask, word);
+    }
+
+    /**
+     * @brief 전처리기 지시자인지 확인
+     * @param word 접두어를 뺀 낱말
+     * @return 지시자이면 true, 아니면 false
+     */
+    bool isDirective(QStringView word) const
+    {
+        return contains(_directives, _directiveMask, word);
+    }
+
+    /**
+     * @brief 문자 종류를 얻음
+     * @param ch 문자
+     * @return 문자 종류
+     */
+    CharClass charClass(QChar ch) const
+    {
+        if (ch.unicode() < 128)
+            return static_cast<CharClass>(_classes[ch.unicode()]);
+
+        return ch.isLetterOrNumber() ? WordChar : OtherChar;
+    }
+
+    /**
+     * @brief 블럭 수를 얻음
+     * @return 블럭 수
+     */
+    int blockCount() const
+    {
+        return _blockCount;
+    }
+
+    /**
+     * @brief 블럭 시작 토큰의 종류를 얻음
+     * @param block 블럭 번호
+     * @return 토큰 종류
+     */
+    Kind blockKind(int block) const
+    {
+        return static_cast<Kind>(_blocks[block].kind);
+    }
+
+    /**
+     * @brief 블럭이 끝나는 토큰을 얻음
+     * @param block 블럭 번호
+     * @return 끝 토큰. 비어 있으면 줄 끝에서 끝남
+     */
+    QStringView blockEnd(int block) const
+    {
+        return _grammar->string(_blocks[block].endOffset,
+                                _blocks[block].endLength);
+    }
+
+    /**
+     * @brief 탈출 문자를 얻음
+     * @return 탈출 문자. 없으면 -1
+     */
+    int escapeChar() const
+    {
+        return _escapeChar;
+    }
+
+    /**
+     * @brief 줄 끝의 탈출 문자로 블럭이 이어지는지 알려줌
+     * @return 이어지면 true, 아니면 false
+     */
+    bool lineContinuation() const
+    {
+        return _lineContinuation;
+    }
+
+    int matchSymbol(QStringView text, Kind *kind, int *block = 0) const;
+    int matchDirective(QStringView text, int pos) const;
+
+    int wordLength(QStringView text, int pos) const;
+
+private:
+    QSharedPointer<const Grammar> _grammar; /// 언어 정의. 표들을 가짐
+
+    // 언어 정의 이미지 안의 표들
+    const uchar *_classes;              /// ASCII 문자마다 문자 종류
+    const qint32 *_roots;               /// ASCII 문자마다 첫 노드. 없으면 -1
+    const Grammar::Node *_nodes;        /// 트라이 노드들
+    const Grammar::Slot *_keywords;     /// 키워드 해시 표
+    const Grammar::Slot *_directives;   /// 지시자 해시 표
+    const Grammar::Block *_blocks;      /// 블럭들
+    const QChar *_strings;              /// 문자열 풀
+
+    quint32 _keywordMask;   /// 키워드 해시 표 크기 - 1
+    quint32 _directiveMask; /// 지시자 해시 표 크기 - 1
+    int _blockCount;        /// 블럭 수
+    int _escapeChar;        /// 탈출 문자. 없으면 -1
+    bool _caseSensitive;    /// 대소문자 구분 여부
+    bool _lineContinuation; /// 줄 끝의 탈출 문자로 블럭이 이어지는지 여부
+
+    bool contains(const Grammar::Slot *table, quint32 mask,
+                  QStringView word) const;
+};
+
+#endif // TOKENMATCHER_H
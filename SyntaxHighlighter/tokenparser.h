@@ -0,0 +1,128 @@
+/****************************************************************************
+**
+** tokenparser.h
+**
+** Copyright (C) 2015 by KO Myung-Hun
+** All rights reserved.
+** Contact: KO Myung-Hun (komh@chollian.net)
+**
+** This file is part of SyntaxHighlighter.
+**
+** $BEGIN_LICENSE$
+**
+** This program is free software. It comes without any warranty, to
+** the extent permitted by applicable law. You can redistribute it
+** and/or modify it under the terms of the Do What The Fuck You Want
+** To Public License, Version 2, as published by Sam Hocevar. See
+** http://www.wtfpl.net/ for more details.
+**
+** $END_LICENSE$
+**
+****************************************************************************/
+
+
+/** @file tokenparser.h
+ */
+
+#ifndef TOKENPARSER_H
+#define TOKENPARSER_H
+
+#include <QString>
+
+/**
+ * @brief 토큰 파서 클래스
+ */
+class TokenParser
+{
+public:
+    /**
+     * @brief TokenParser 생성자
+     * @param s 파싱할 문자열
+     */
+    explicit TokenParser(const QString s = QString())
+        : _s(s)
+        , _currentPos(0)
+
+    {
+    }
+
+    /**
+     * @brief 남은 토큰이 있는지 확인
+     * @return 토큰이 있으면 true, 없으면 false
+     */
+    bool hasNext() const
+    {
+        return _currentPos < _s.length();
+    }
+
+    /**
+     * @brief 토큰을 읽고 다음으로 이동
+     * @return 읽은 토큰
+     */
+    QString next()
+    {
+        return nextCommon();
+    }
+
+    /**
+     * @brief 토큰을 읽지만 다음으로 이동하지 않음
+     * @return 읽은 토큰
+     */
+    QString peekNext()
+    {
+        return nextCommon(false);
+    }
+
+    /**
+     * @brief 현재 파싱 위치를 얻음
+     * @return 현재 파싱 위치
+     */
+    int currentPos()
+    {
+        return _currentPos;
+    }
+
+    /**
+     * @brief 파싱할 위치 설정
+     * @param currentPos 새로운 파싱 위치
+     */
+    void setCurrentPos(int currentPos)
+    {
+        _currentPos = currentPos;
+    }
+
+private:
+    QString _s;         /// 파싱할 문자열
+
+    int _currentPos;    /// 파싱할 위치
+
+    /**
+     * @brief 토큰을 읽음
+     * @param nextMode true 이면 다음으로 이동, 아니면 이동하지 않음
+     * @return 읽은 토큰
+     */
+    QString nextCommon(bool nextMode = true)
+    {
+        int start = _currentPos;
+        int end = _currentPos;
+        QChar ch;
+
+        // 연속된 문자, 숫자, _ 은 하나의 토큰
+        while (end < _s.length()
+               && ((ch = _s.at(end)).isLetterOrNumber() || ch == '_'))
+            ++end;
+
+        // 문자, 숫자, _ 가 아니면 한 문자가 하나의 토큰
+        if (end < _s.length() && start == end
+                && !((ch = _s.at(end)).isLetterOrNumber() || ch == '_'))
+            ++end;
+
+        // next mode 이면 파싱위치 이동
+        if (nextMode)
+            _currentPos = end;
+
+        return _s.mid(start, end - start);
+    }
+};
+
+#endif // TOKENPARSER_H